@@ -0,0 +1,314 @@
+#include "compiled_circuit.h"
+#include "stabilizer_circuit.h"
+#include "improved_simulation_of_stabilizer_circuits/fixed_stabilizer_tableau.h"
+#include "improved_simulation_of_stabilizer_circuits/improved_stabilizer_tableau.h"
+#include "stim_a_fast_stabilizer_circuit_simulator/frame_simulator.h"
+#include "stim_a_fast_stabilizer_circuit_simulator/packed_stabilizer_tableau.h"
+#include "sparse_stabilizer_tableau/sparse_stabilizer_tableau.h"
+#include "benchmark/benchmark.h"
+
+#include <random>
+#include <string>
+#include <unordered_map>
+
+// Run with --benchmark_format=json (or --benchmark_out=<file> --benchmark_out_format=json) for machine-readable output.
+// The gate, measurement and rowsum benchmarks report gates/s, the circuit benchmarks shots/s and gates/s.
+
+using namespace CliffordTableaus;
+
+namespace {
+    /**
+     * Exposes the protected rowsum subroutine for benchmarking.
+     */
+    class RowsumProbe : public ImprovedStabilizerTableau {
+    public:
+        using ImprovedStabilizerTableau::rowsum;
+    };
+
+    /**
+     * Bring the tableau into a random stabilizer state, so that the benchmarks do not run on the sparse initial tableau.
+     */
+    void scramble(StabilizerTableau &tableau, std::size_t n, std::mt19937 &generator) {
+        std::uniform_int_distribution<std::size_t> qubit_dist(1, n);
+        for (std::size_t step = 0; step < 4 * n; ++step) {
+            auto a = qubit_dist(generator);
+            auto b = qubit_dist(generator);
+            tableau.Hadamard(a);
+            tableau.Phase(b);
+            if (a != b) {
+                tableau.CNOT(a, b);
+            }
+        }
+    }
+
+    void setGateCounters(benchmark::State &state) {
+        state.counters["gates/s"] = benchmark::Counter(static_cast<double>(state.iterations()),
+                                                       benchmark::Counter::kIsRate);
+    }
+
+    template<class Tableau>
+    void BM_CNOT(benchmark::State &state) {
+        auto n = static_cast<std::size_t>(state.range(0));
+        std::mt19937 generator(1);
+        Tableau tableau;
+        tableau.initializeTableau(n);
+        scramble(tableau, n, generator);
+        std::size_t a = 1;
+        for (auto _: state) {
+            tableau.CNOT(a, a % n + 1);
+            a = a % n + 1;
+        }
+        setGateCounters(state);
+    }
+
+    template<class Tableau>
+    void BM_Hadamard(benchmark::State &state) {
+        auto n = static_cast<std::size_t>(state.range(0));
+        std::mt19937 generator(1);
+        Tableau tableau;
+        tableau.initializeTableau(n);
+        scramble(tableau, n, generator);
+        std::size_t a = 1;
+        for (auto _: state) {
+            tableau.Hadamard(a);
+            a = a % n + 1;
+        }
+        setGateCounters(state);
+    }
+
+    template<class Tableau>
+    void BM_Phase(benchmark::State &state) {
+        auto n = static_cast<std::size_t>(state.range(0));
+        std::mt19937 generator(1);
+        Tableau tableau;
+        tableau.initializeTableau(n);
+        scramble(tableau, n, generator);
+        std::size_t a = 1;
+        for (auto _: state) {
+            tableau.Phase(a);
+            a = a % n + 1;
+        }
+        setGateCounters(state);
+    }
+
+    template<class Tableau>
+    void BM_MeasurementDeterministic(benchmark::State &state) {
+        // Every qubit of a state built from CNOTs only is in a computational basis state,
+        // so all measurements have a determinate outcome while the destabilizers are still dense.
+        auto n = static_cast<std::size_t>(state.range(0));
+        std::mt19937 generator(1);
+        std::uniform_int_distribution<std::size_t> qubit_dist(1, n);
+        Tableau tableau;
+        tableau.initializeTableau(n);
+        for (std::size_t step = 0; step < 4 * n; ++step) {
+            auto a = qubit_dist(generator);
+            auto b = qubit_dist(generator);
+            tableau.PauliX(a);
+            if (a != b) {
+                tableau.CNOT(a, b);
+            }
+        }
+        std::size_t a = 1;
+        for (auto _: state) {
+            benchmark::DoNotOptimize(tableau.Measurement(a));
+            a = a % n + 1;
+        }
+        setGateCounters(state);
+    }
+
+    template<class Tableau>
+    void BM_MeasurementRandom(benchmark::State &state) {
+        // The Hadamard brings the qubit measured in the previous iteration back into superposition.
+        auto n = static_cast<std::size_t>(state.range(0));
+        std::mt19937 generator(1);
+        Tableau tableau;
+        tableau.initializeTableau(n);
+        scramble(tableau, n, generator);
+        std::size_t a = 1;
+        for (auto _: state) {
+            tableau.Hadamard(a);
+            benchmark::DoNotOptimize(tableau.Measurement(a));
+            a = a % n + 1;
+        }
+        setGateCounters(state);
+    }
+
+    template<class Tableau>
+    void BM_InitializeTableau(benchmark::State &state) {
+        // Every shot starts from |0...0〉, so the reset is paid once per shot.
+        auto n = static_cast<std::size_t>(state.range(0));
+        Tableau tableau;
+        for (auto _: state) {
+            tableau.initializeTableau(n);
+            benchmark::ClobberMemory();
+        }
+        setGateCounters(state);
+    }
+
+    void BM_Rowsum(benchmark::State &state) {
+        auto n = static_cast<std::size_t>(state.range(0));
+        std::mt19937 generator(1);
+        RowsumProbe tableau;
+        tableau.initializeTableau(n);
+        scramble(tableau, n, generator);
+        // Stabilizer generators commute pairwise, so every pair is a valid rowsum.
+        std::size_t h = n + 1;
+        for (auto _: state) {
+            tableau.rowsum(h, h % n + n + 1);
+            h = h % n + n + 1;
+        }
+        setGateCounters(state);
+    }
+
+    template<class Tableau, bool batched>
+    void BM_MeasureAllQubits(benchmark::State &state) {
+        // Every iteration restores a scrambled state and measures all of its qubits,
+        // either with MeasureAll or one after the other.
+        auto n = static_cast<std::size_t>(state.range(0));
+        std::mt19937 generator(1);
+        Tableau tableau;
+        tableau.initializeTableau(n);
+        scramble(tableau, n, generator);
+        TableauSnapshot snapshot;
+        tableau.saveSnapshot(snapshot);
+        for (auto _: state) {
+            tableau.restoreSnapshot(snapshot);
+            if constexpr (batched) {
+                benchmark::DoNotOptimize(tableau.MeasureAll());
+            } else {
+                for (std::size_t a = 1; a <= n; ++a) {
+                    benchmark::DoNotOptimize(tableau.Measurement(a));
+                }
+            }
+        }
+        state.counters["shots/s"] = benchmark::Counter(static_cast<double>(state.iterations()),
+                                                       benchmark::Counter::kIsRate);
+    }
+
+    void setShotCounters(benchmark::State &state, const CompiledCircuit &circuit) {
+        auto shots = static_cast<double>(state.iterations());
+        state.counters["shots/s"] = benchmark::Counter(shots, benchmark::Counter::kIsRate);
+        state.counters["gates/s"] = benchmark::Counter(
+                shots * static_cast<double>(circuit.optimizationStats().gates_before), benchmark::Counter::kIsRate);
+    }
+
+    template<class Tableau>
+    void runCircuitShots(benchmark::State &state, const CompiledCircuit &circuit, Tableau &tableau) {
+        Rng rng(1);
+        for (auto _: state) {
+            benchmark::DoNotOptimize(circuit.run(tableau, rng));
+        }
+        setShotCounters(state, circuit);
+    }
+
+    template<class Tableau>
+    void BM_Circuit(benchmark::State &state, const std::string &circuit_filename) {
+        auto circuit = CompiledCircuit::load(circuit_filename);
+        Tableau tableau;
+        runCircuitShots(state, circuit, tableau);
+    }
+
+    /**
+     * Same as BM_Circuit, but through the virtual interface of StabilizerTableau as in the interactive mode.
+     */
+    template<class Tableau>
+    void BM_CircuitVirtual(benchmark::State &state, const std::string &circuit_filename) {
+        auto circuit = CompiledCircuit::load(circuit_filename);
+        Tableau tableau;
+        runCircuitShots(state, circuit, static_cast<StabilizerTableau &>(tableau));
+    }
+
+    void BM_CircuitFixed(benchmark::State &state, const std::string &circuit_filename) {
+        auto circuit = CompiledCircuit::load(circuit_filename);
+        if (circuit.qubits() <= 64) {
+            FixedStabilizerTableau<64> tableau;
+            runCircuitShots(state, circuit, tableau);
+        } else if (circuit.qubits() <= 128) {
+            FixedStabilizerTableau<128> tableau;
+            runCircuitShots(state, circuit, tableau);
+        } else if (circuit.qubits() <= 256) {
+            FixedStabilizerTableau<256> tableau;
+            runCircuitShots(state, circuit, tableau);
+        } else {
+            state.SkipWithError("Circuit too wide for FixedStabilizerTableau");
+        }
+    }
+
+    void BM_FrameSampler(benchmark::State &state, const std::string &circuit_filename) {
+        auto circuit = CompiledCircuit::load(circuit_filename);
+        PackedStabilizerTableau tableau;
+        Rng rng(1);
+        FrameSimulator simulator(circuit, circuit.run(tableau, rng));
+        std::unordered_map<std::string, unsigned int> histogram;
+        for (auto _: state) {
+            simulator.sampleBatch(simulator.batchSize(), rng, histogram);
+        }
+        auto shots = static_cast<double>(state.iterations() * simulator.batchSize());
+        state.counters["shots/s"] = benchmark::Counter(shots, benchmark::Counter::kIsRate);
+    }
+
+    /**
+     * Register the end-to-end benchmarks of a circuit for all backends.
+     */
+    void registerCircuit(const std::string &name, const std::string &circuit_filename) {
+        benchmark::RegisterBenchmark(("BM_Circuit<Improved>/" + name).c_str(),
+                                     BM_Circuit<ImprovedStabilizerTableau>, circuit_filename);
+        benchmark::RegisterBenchmark(("BM_CircuitVirtual<Improved>/" + name).c_str(),
+                                     BM_CircuitVirtual<ImprovedStabilizerTableau>, circuit_filename);
+        benchmark::RegisterBenchmark(("BM_Circuit<Fixed>/" + name).c_str(), BM_CircuitFixed, circuit_filename);
+        benchmark::RegisterBenchmark(("BM_Circuit<Packed>/" + name).c_str(),
+                                     BM_Circuit<PackedStabilizerTableau>, circuit_filename);
+        benchmark::RegisterBenchmark(("BM_Circuit<Sparse>/" + name).c_str(),
+                                     BM_Circuit<SparseStabilizerTableau>, circuit_filename);
+        benchmark::RegisterBenchmark(("BM_FrameSampler/" + name).c_str(), BM_FrameSampler, circuit_filename);
+    }
+}
+
+#define TABLEAU_BENCHMARK(function, tableau) \
+    BENCHMARK(function<tableau>)->RangeMultiplier(4)->Range(16, 4096)
+
+TABLEAU_BENCHMARK(BM_CNOT, ImprovedStabilizerTableau);
+TABLEAU_BENCHMARK(BM_CNOT, PackedStabilizerTableau);
+BENCHMARK(BM_CNOT<FixedStabilizerTableau<64>>)->Arg(64);
+BENCHMARK(BM_CNOT<FixedStabilizerTableau<256>>)->Arg(256);
+TABLEAU_BENCHMARK(BM_CNOT, SparseStabilizerTableau);
+TABLEAU_BENCHMARK(BM_Hadamard, ImprovedStabilizerTableau);
+TABLEAU_BENCHMARK(BM_Hadamard, PackedStabilizerTableau);
+TABLEAU_BENCHMARK(BM_Hadamard, SparseStabilizerTableau);
+TABLEAU_BENCHMARK(BM_Phase, ImprovedStabilizerTableau);
+TABLEAU_BENCHMARK(BM_Phase, PackedStabilizerTableau);
+TABLEAU_BENCHMARK(BM_Phase, SparseStabilizerTableau);
+TABLEAU_BENCHMARK(BM_MeasurementDeterministic, ImprovedStabilizerTableau);
+TABLEAU_BENCHMARK(BM_MeasurementDeterministic, PackedStabilizerTableau);
+TABLEAU_BENCHMARK(BM_MeasurementDeterministic, SparseStabilizerTableau);
+TABLEAU_BENCHMARK(BM_MeasurementRandom, ImprovedStabilizerTableau);
+TABLEAU_BENCHMARK(BM_MeasurementRandom, PackedStabilizerTableau);
+TABLEAU_BENCHMARK(BM_MeasurementRandom, SparseStabilizerTableau);
+TABLEAU_BENCHMARK(BM_InitializeTableau, ImprovedStabilizerTableau);
+TABLEAU_BENCHMARK(BM_InitializeTableau, PackedStabilizerTableau);
+TABLEAU_BENCHMARK(BM_InitializeTableau, SparseStabilizerTableau);
+BENCHMARK(BM_MeasureAllQubits<ImprovedStabilizerTableau, false>)->RangeMultiplier(4)->Range(16, 1024);
+BENCHMARK(BM_MeasureAllQubits<ImprovedStabilizerTableau, true>)->RangeMultiplier(4)->Range(16, 1024);
+BENCHMARK(BM_Rowsum)->RangeMultiplier(4)->Range(16, 4096);
+
+int main(int argc, char **argv) {
+    for (int i = 1; i <= 9; ++i) {
+        auto name = "random_circuit_" + std::to_string(i);
+        registerCircuit(name, name + ".qasm");
+    }
+    // Circuits generated on the fly with 10 gates per qubit, followed by a measurement of all qubits.
+    for (std::size_t n: {16, 64, 256, 1024}) {
+        auto name = "generated_" + std::to_string(n);
+        StabilizerCircuit::createRandomStabilizerCircuit("benchmark_" + name + ".qasm", n, 10 * n, n, n + 1,
+                                                         false, true, true);
+        registerCircuit(name, "benchmark_" + name + ".qasm");
+    }
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -3,11 +3,22 @@
 #include <fstream>
 #include <unordered_map>
 #include <algorithm>
+#include <optional>
+#include <iomanip>
+#include <limits>
+#include <stdexcept>
 #include <getopt.h>
 
 #include "stabilizer_circuit.h"
+#include "compiled_circuit.h"
 #include "stabilizer_tableau.h"
 #include "improved_stabilizer_tableau.h"
+#include "fixed_stabilizer_tableau.h"
+#include "packed_stabilizer_tableau.h"
+#include "sparse_stabilizer_tableau.h"
+#include "simd_kernels.h"
+#include "shot_runner.h"
+#include "instrumentation.h"
 
 using namespace CliffordTableaus;
 
@@ -15,6 +26,8 @@ void print_help(const char *program_name);
 
 void print_progress(unsigned int current, unsigned int total);
 
+std::unique_ptr<StabilizerTableau> make_tableau(unsigned int stabilizer_id, CliffordTableaus::uint n_qubits = 0);
+
 
 int main(int argc, char *argv[]) {
     std::string input_filename;
@@ -23,6 +36,12 @@ int main(int argc, char *argv[]) {
     // Default to ImprovedStabilizerTableau
     unsigned int stabilizer_id = 1;
     unsigned int num_shots = 1;
+    unsigned int num_threads = 1;
+    std::string simd_level = "auto";
+    std::string sampler = "tableau";
+    std::optional<CliffordTableaus::uint> seed;
+    std::string stats_filename;
+    std::string exact;
 
     // Define options
     struct option long_options[] = {
@@ -30,12 +49,18 @@ int main(int argc, char *argv[]) {
             {"stabilizer", required_argument, nullptr, 's'},
             {"output",     required_argument, nullptr, 'o'},
             {"num-shots",  required_argument, nullptr, 'n'},
+            {"threads",    required_argument, nullptr, 't'},
+            {"simd",       required_argument, nullptr, 'S'},
+            {"sampler",    required_argument, nullptr, 'F'},
+            {"seed",       required_argument, nullptr, 'R'},
+            {"stats",      required_argument, nullptr, 'T'},
+            {"exact",      optional_argument, nullptr, 'E'},
             {"help",       no_argument,       nullptr, 'h'},
             {nullptr, 0,                      nullptr, 0}
     };
 
     int opt;
-    while ((opt = getopt_long(argc, argv, "i:s:o:n:h", long_options, nullptr)) != -1) {
+    while ((opt = getopt_long(argc, argv, "i:s:o:n:t:h", long_options, nullptr)) != -1) {
         switch (opt) {
             case 'i':
                 input_filename = optarg;
@@ -49,6 +74,36 @@ int main(int argc, char *argv[]) {
             case 'n':
                 num_shots = std::stoul(optarg);
                 break;
+            case 't':
+                num_threads = std::stoul(optarg);
+                break;
+            case 'S':
+                simd_level = optarg;
+                break;
+            case 'F':
+                sampler = optarg;
+                if (sampler != "tableau" && sampler != "frame") {
+                    std::cerr << "Error: Unsupported sampler: " << sampler << std::endl;
+                    return 1;
+                }
+                break;
+            case 'R':
+                seed = std::stoull(optarg);
+                break;
+            case 'T':
+                stats_filename = optarg;
+                if (!Stats::enabled) {
+                    std::cerr << "Error: --stats requires a build with -DCLIFFORD_TABLEAUS_STATS=ON" << std::endl;
+                    return 1;
+                }
+                break;
+            case 'E':
+                exact = optarg ? optarg : "histogram";
+                if (exact != "histogram" && exact != "subspace") {
+                    std::cerr << "Error: Unsupported exact output: " << exact << std::endl;
+                    return 1;
+                }
+                break;
             case 'h':
                 print_help(argv[0]);
                 return 0;
@@ -58,53 +113,107 @@ int main(int argc, char *argv[]) {
         }
     }
 
+    // Select the SIMD kernels, by default the best ones supported by the CPU
+    try {
+        if (simd_level != "auto") {
+            select_simd_level(parse_simd_level(simd_level));
+        }
+    } catch (const std::exception &e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
     // Select stabilizer tableau
-    std::unique_ptr<StabilizerTableau> stabilizerTableau;
-    // NOLINTNEXTLINE
-    switch (stabilizer_id) {
-        case 1:
-            stabilizerTableau = std::make_unique<ImprovedStabilizerTableau>();
-            break;
-        default:
-            std::cerr << "Error: Unsupported stabilizer algorithm ID: " << stabilizer_id << std::endl;
-            return 1;
+    std::unique_ptr<StabilizerTableau> stabilizerTableau = make_tableau(stabilizer_id);
+    if (!stabilizerTableau) {
+        std::cerr << "Error: Unsupported stabilizer algorithm ID: " << stabilizer_id << std::endl;
+        return 1;
     }
 
     try {
+        if (input_filename.empty() && !exact.empty()) {
+            std::cerr << "Error: --exact requires an input circuit" << std::endl;
+            return 1;
+        }
         if (input_filename.empty()) {
-            // Interactive mode
+            // Interactive mode, with reproducible outcomes if a seed is given
+            Rng rng(seed.value_or(random_seed()));
+            stabilizerTableau->setRng(&rng);
             std::string result = StabilizerCircuit::interactiveMode(*stabilizerTableau);
             std::cout << "Final measurement: " << result << std::endl;
         } else {
-            // Read circuit from file
-            std::unordered_map<std::string, unsigned int> measurement_results;
-            std::cout << "Measurement of " << input_filename << " in progress..." << std::endl;
-            for (unsigned int shot = 0; shot < num_shots; ++shot) {
-                std::string measurement = StabilizerCircuit::executeCircuit(input_filename, *stabilizerTableau);
-                ++measurement_results[measurement];
-
-                if (shot % (num_shots / 100) == 0) {
-                    print_progress(shot + 1, num_shots);
+            std::ostringstream output;
+            if (num_shots == 1 && exact.empty() && sampler == "tableau") {
+                // A single shot streams the circuit through the tableau chunk by chunk,
+                // so the memory is bounded by the tableau no matter how many gates the circuit has
+                std::cout << "Measurement of " << input_filename << " in progress..." << std::endl;
+                Rng rng(seed.value_or(random_seed()));
+                stabilizerTableau->setRng(&rng);
+                auto result = StabilizerCircuit::executeCircuit(input_filename, *stabilizerTableau);
+                stabilizerTableau->setRng(nullptr);
+                if (result.empty()) {
+                    throw std::runtime_error("Invalid QASM3 circuit: " + input_filename);
                 }
-            }
-            print_progress(num_shots, num_shots);
-            std::cout << std::endl;
+                output << "{\"" << result << "\": 1}";
+            } else {
+                // Read circuit from file once, every shot only performs tableau work
+                auto circuit = CompiledCircuit::load(input_filename);
+                const auto &stats = circuit.optimizationStats();
+                std::cerr << "Optimization removed " << stats.removed() << " of " << stats.gates_before << " gates"
+                          << std::endl;
+                if (!exact.empty()) {
+                    // The final measurement is uniformly distributed over an affine subspace, no shots are needed
+                    auto tableau = make_tableau(stabilizer_id, circuit.qubits());
+                    auto distribution = circuit.exactDistribution(*tableau);
+                    output << std::setprecision(std::numeric_limits<double>::max_digits10);
+                    if (exact == "subspace") {
+                        output << "{\"dimension\": " << distribution.dimension()
+                               << ", \"probability\": " << distribution.probability()
+                               << ", \"offset\": \"" << distribution.offsetString() << "\", \"basis\": [";
+                        auto basis = distribution.basisStrings();
+                        for (size_t i = 0; i < basis.size(); ++i) {
+                            output << (i > 0 ? ", " : "") << "\"" << basis[i] << "\"";
+                        }
+                        output << "]}";
+                    } else {
+                        auto outcomes = distribution.outcomes();
+                        std::sort(outcomes.begin(), outcomes.end());
+                        output << "{";
+                        for (size_t i = 0; i < outcomes.size(); ++i) {
+                            output << (i > 0 ? ", " : "") << "\"" << outcomes[i] << "\": " << distribution.probability();
+                        }
+                        output << "}";
+                    }
+                } else {
+                    std::cout << "Measurement of " << input_filename << " in progress..." << std::endl;
+                    // Every worker thread owns its own tableau (or frames), every shot (or batch) its own RNG stream
+                    auto run = sampler == "frame" ? ShotRunner::sampleFrames : ShotRunner::runShots;
+                    auto measurement_results = run(
+                            circuit,
+                            [stabilizer_id, n_qubits = circuit.qubits()] { return make_tableau(stabilizer_id, n_qubits); },
+                            num_shots,
+                            num_threads,
+                            [](CliffordTableaus::uint completed, CliffordTableaus::uint total) { print_progress(completed, total); },
+                            seed
+                    );
+                    std::cout << std::endl;
 
-            // Sort and output results
-            std::vector<std::pair<std::string, unsigned int>> sorted_results(
-                    measurement_results.begin(), measurement_results.end()
-            );
-            std::sort(sorted_results.begin(), sorted_results.end());
+                    // Sort and output results
+                    std::vector<std::pair<std::string, unsigned int>> sorted_results(
+                            measurement_results.begin(), measurement_results.end()
+                    );
+                    std::sort(sorted_results.begin(), sorted_results.end());
 
-            std::ostringstream output;
-            output << "{";
-            for (size_t i = 0; i < sorted_results.size(); ++i) {
-                output << "\"" << sorted_results[i].first << "\": " << sorted_results[i].second;
-                if (i < sorted_results.size() - 1) {
-                    output << ", ";
+                    output << "{";
+                    for (size_t i = 0; i < sorted_results.size(); ++i) {
+                        output << "\"" << sorted_results[i].first << "\": " << sorted_results[i].second;
+                        if (i < sorted_results.size() - 1) {
+                            output << ", ";
+                        }
+                    }
+                    output << "}";
                 }
             }
-            output << "}";
 
             // Write to file if output filename is provided
             if (!output_filename.empty()) {
@@ -125,20 +234,73 @@ int main(int argc, char *argv[]) {
         return 1;
     }
 
+    // Write the instrumentation counters of the whole run
+    if (!stats_filename.empty()) {
+        std::ofstream stats_file(stats_filename);
+        if (!stats_file) {
+            std::cerr << "Error: Unable to write to file: " << stats_filename << std::endl;
+            return 1;
+        }
+        stats_file << Stats::toJson() << std::endl;
+    }
+
     return 0;
 }
 
 void print_help(const char *program_name) {
     std::cout << "Usage: " << program_name << " [OPTIONS]\n"
               << "OPTIONS:\n"
-              << "  -i, --input <input_filename>       Input file containing the circuit in QASM3 format.\n"
+              << "  -i, --input <input_filename>       Input file containing the circuit in QASM3 format\n"
+              << "                                     or in binary format (see qasm2bin).\n"
               << "  -s, --stabilizer <stabilizer-id>   Stabilizer algorithm ID (default: 1).\n"
+              << "                                     1: Improved stabilizer tableau, specialized at compile time\n"
+              << "                                        for circuits of up to 64, 128 or 256 qubits.\n"
+              << "                                     2: Packed bit-plane stabilizer tableau.\n"
+              << "                                     3: Sparse stabilizer tableau for wide, weakly entangled circuits.\n"
               << "  -o, --output <output_filename>     Output file for measurement results.\n"
-              << "  -n, --num-shots <num-shots>        Number of shots to execute (default: 1).\n"
+              << "  -n, --num-shots <num-shots>        Number of shots to execute (default: 1). A single shot\n"
+              << "                                     streams a QASM circuit instead of loading it at once.\n"
+              << "  -t, --threads <num-threads>        Number of threads executing the shots (default: 1).\n"
+              << "                                     0: One thread per hardware thread.\n"
+              << "      --simd=<level>                SIMD kernels for the tableau updates, one of auto, scalar,\n"
+              << "                                     avx2, avx512 or avx512vpopcntdq (default: auto).\n"
+              << "      --sampler=<tableau|frame>     Simulate every shot with a tableau, or sample the shots with\n"
+              << "                                     Pauli frames from one reference shot (default: tableau).\n"
+              << "      --seed=<seed>                 Seed of the measurement outcomes. Results are reproducible\n"
+              << "                                     for every number of threads (default: random).\n"
+              << "      --stats=<stats_filename>      Write counts (and TSC cycles) of the gates, measurements and\n"
+              << "                                     rowsums and the parse time as JSON. Requires a build with\n"
+              << "                                     -DCLIFFORD_TABLEAUS_STATS=ON (cycles: CLIFFORD_TABLEAUS_CYCLES).\n"
+              << "      --exact[=<histogram|subspace>]  Compute the exact distribution of the final measurement\n"
+              << "                                     instead of executing shots: every outcome with its\n"
+              << "                                     probability, or the affine subspace of the outcomes as\n"
+              << "                                     offset and basis (default: histogram).\n"
               << "  -h, --help                         Display this help message and exit.\n";
 }
 
+std::unique_ptr<StabilizerTableau> make_tableau(unsigned int stabilizer_id, CliffordTableaus::uint n_qubits) {
+    switch (stabilizer_id) {
+        case 1:
+            // Circuits of known, small width use the instantiation of the improved tableau fixed to their size
+            if (n_qubits > 0) {
+                if (auto fixed = makeFixedStabilizerTableau(n_qubits)) {
+                    return fixed;
+                }
+            }
+            return std::make_unique<ImprovedStabilizerTableau>();
+        case 2:
+            return std::make_unique<PackedStabilizerTableau>();
+        case 3:
+            return std::make_unique<SparseStabilizerTableau>();
+        default:
+            return nullptr;
+    }
+}
+
 void print_progress(unsigned int current, unsigned int total) {
+    if (total == 0) {
+        return;
+    }
     int progress = static_cast<int>(100.0 * current / total);
     int bar_width = 50;
     int pos = bar_width * progress / 100;
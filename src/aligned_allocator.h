@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
+
+namespace CliffordTableaus {
+    /**
+     * Allocator for storage aligned to a cache line, which is also the width of the widest vector registers.
+     * The word-parallel kernels then never split a vector load across two cache lines
+     * as long as the rows or columns they process start at multiples of the alignment.
+     * @tparam T Type of the elements.
+     * @tparam Alignment Alignment in bytes.
+     */
+    template<class T, std::size_t Alignment = 64>
+    struct AlignedAllocator {
+        using value_type = T;
+
+        template<class U>
+        struct rebind {
+            using other = AlignedAllocator<U, Alignment>;
+        };
+
+        AlignedAllocator() = default;
+
+        template<class U>
+        explicit AlignedAllocator(const AlignedAllocator<U, Alignment> &) noexcept {}
+
+        T *allocate(std::size_t count) {
+            return static_cast<T *>(::operator new(count * sizeof(T), std::align_val_t{Alignment}));
+        }
+
+        void deallocate(T *pointer, std::size_t) noexcept {
+            ::operator delete(pointer, std::align_val_t{Alignment});
+        }
+
+        template<class U>
+        bool operator==(const AlignedAllocator<U, Alignment> &) const noexcept {
+            return true;
+        }
+    };
+
+    /**
+     * Words of a tableau. The tableaus keep their storage across initializeTableau and restoreSnapshot,
+     * so that executing many shots or circuits of the same width allocates it only once.
+     */
+    using TableauWords = std::vector<uint64_t, AlignedAllocator<uint64_t>>;
+}
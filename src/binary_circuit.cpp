@@ -0,0 +1,110 @@
+#include "binary_circuit.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+namespace CliffordTableaus {
+    namespace {
+        /**
+         * Write an unsigned LEB128 varint: 7 bits per byte, least significant group first,
+         * the high bit of every byte but the last is set.
+         */
+        void writeVarint(std::ostream &output, uint64_t value) {
+            while (value >= 0x80) {
+                output.put(static_cast<char>((value & 0x7F) | 0x80));
+                value >>= 7;
+            }
+            output.put(static_cast<char>(value));
+        }
+
+        /**
+         * Read an unsigned LEB128 varint and advance the position past it.
+         * Throws a runtime error if the varint is truncated or does not fit into 64 bits.
+         */
+        uint64_t readVarint(const std::vector<char> &buffer, std::size_t &position) {
+            uint64_t value = 0;
+            for (unsigned int shift = 0; shift < 64; shift += 7) {
+                if (position >= buffer.size()) {
+                    throw std::runtime_error("Binary circuit is truncated.");
+                }
+                auto byte = static_cast<uint8_t>(buffer[position++]);
+                value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+                if ((byte & 0x80) == 0) {
+                    return value;
+                }
+            }
+            throw std::runtime_error("Binary circuit contains an overlong varint.");
+        }
+
+        uint32_t readQubit(const std::vector<char> &buffer, std::size_t &position) {
+            auto qubit = readVarint(buffer, position);
+            if (qubit > std::numeric_limits<uint32_t>::max()) {
+                throw std::runtime_error("Binary circuit contains an invalid qubit index.");
+            }
+            return static_cast<uint32_t>(qubit);
+        }
+    }
+
+    bool BinaryCircuit::isBinaryCircuit(const std::filesystem::path &circuit_path) {
+        std::ifstream file(circuit_path, std::ios::binary);
+        std::array<char, 4> header{};
+        return file.read(header.data(), header.size()) && header == magic;
+    }
+
+    void BinaryCircuit::writeHeader(std::ostream &output, uint n_qubits) {
+        output.write(magic.data(), magic.size());
+        output.put(static_cast<char>(version));
+        writeVarint(output, n_qubits);
+    }
+
+    void BinaryCircuit::writeInstruction(std::ostream &output, const Instruction &instruction) {
+        output.put(static_cast<char>(instruction.gate));
+        writeVarint(output, instruction.qubit1);
+        if (instruction.gate == CNOT || instruction.gate == SWAP || instruction.gate == CLIFFORD) {
+            writeVarint(output, instruction.qubit2);
+        }
+    }
+
+    void BinaryCircuit::read(const std::filesystem::path &circuit_path, uint &n_qubits,
+                             std::vector<Instruction> &instructions) {
+        std::ifstream file(circuit_path, std::ios::binary);
+        if (!file.is_open()) {
+            throw std::runtime_error("Unable to open file for reading: " + circuit_path.string());
+        }
+        std::vector<char> buffer((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+        if (buffer.size() < magic.size() + 1 || !std::equal(magic.begin(), magic.end(), buffer.begin())) {
+            throw std::runtime_error("Not a binary circuit file: " + circuit_path.string());
+        }
+        auto file_version = static_cast<uint8_t>(buffer[magic.size()]);
+        if (file_version != version) {
+            throw std::runtime_error("Unsupported binary circuit version " + std::to_string(file_version) +
+                                     ": " + circuit_path.string());
+        }
+        std::size_t position = magic.size() + 1;
+        auto declared_qubits = readVarint(buffer, position);
+        if (declared_qubits > std::numeric_limits<uint>::max() || declared_qubits > max_qubits) {
+            throw std::runtime_error("Binary circuit declares too many qubits.");
+        }
+        n_qubits = static_cast<uint>(declared_qubits);
+
+        instructions.clear();
+        // Every record takes at least 2 bytes.
+        instructions.reserve((buffer.size() - position) / 2);
+        while (position < buffer.size()) {
+            auto opcode = static_cast<uint8_t>(buffer[position++]);
+            if (opcode > CLIFFORD) {
+                throw std::runtime_error("Binary circuit contains an invalid opcode " + std::to_string(opcode) + ".");
+            }
+            Instruction instruction{static_cast<Gate>(opcode), readQubit(buffer, position), 0};
+            if (instruction.gate == CNOT || instruction.gate == SWAP || instruction.gate == CLIFFORD) {
+                instruction.qubit2 = readQubit(buffer, position);
+            }
+            instructions.push_back(instruction);
+        }
+    }
+}
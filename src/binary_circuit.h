@@ -0,0 +1,75 @@
+#pragma once
+
+#include "circuit_instruction.h"
+
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <ostream>
+#include <vector>
+
+namespace CliffordTableaus {
+    using uint = std::size_t;
+
+    /**
+     * Compact binary file format for compiled stabilizer circuits, typically 2-4 bytes per gate.
+     * The layout of a file is:
+     * 1. The magic number "CTBC".
+     * 2. One byte holding the version of the format.
+     * 3. The number of qubits as unsigned LEB128 varint.
+     * 4. One record per instruction until the end of the file:
+     *    the opcode (the Gate) as one byte, followed by qubit1 as varint,
+     *    followed by qubit2 as varint for the two-qubit gates CNOT and SWAP
+     *    and by the code of the SingleQubitClifford for CLIFFORD.
+     * Qubit indices are 0-based as in the QASM3 format.
+     */
+    class BinaryCircuit {
+    public:
+        /**
+         * The magic number at the start of every binary circuit file.
+         */
+        static constexpr std::array<char, 4> magic = {'C', 'T', 'B', 'C'};
+
+        /**
+         * The version of the format written by this implementation.
+         */
+        static constexpr uint8_t version = 1;
+
+        /**
+         * The largest number of qubits accepted by read. The tableaus take O(n^2) bits,
+         * so a corrupt header must not make them allocate far beyond any simulable circuit.
+         */
+        static constexpr uint max_qubits = uint{1} << 20;
+
+        /**
+         * Check whether the file starts with the magic number of the binary format.
+         * @param circuit_path Path to the circuit file.
+         * @return Whether the file is a binary circuit file.
+         */
+        static bool isBinaryCircuit(const std::filesystem::path &circuit_path);
+
+        /**
+         * Write the header of a binary circuit file.
+         * @param output Stream to write to, opened in binary mode.
+         * @param n_qubits Number of qubits of the circuit.
+         */
+        static void writeHeader(std::ostream &output, uint n_qubits);
+
+        /**
+         * Write the record of one instruction.
+         * @param output Stream to write to, after the header.
+         * @param instruction Instruction to write.
+         */
+        static void writeInstruction(std::ostream &output, const Instruction &instruction);
+
+        /**
+         * Read a binary circuit file.
+         * Throws a runtime error if the file cannot be read, has an unsupported version or is malformed.
+         * @param circuit_path Path to the circuit file.
+         * @param n_qubits Number of qubits declared by the circuit.
+         * @param instructions The instructions of the circuit in order of execution.
+         */
+        static void read(const std::filesystem::path &circuit_path, uint &n_qubits,
+                         std::vector<Instruction> &instructions);
+    };
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+
+namespace CliffordTableaus {
+    /**
+     * Supported gates in the stabilizer circuit.
+     * Also serves as the opcode of a compiled Instruction.
+     */
+    enum Gate : uint8_t {
+        IDENTITY,
+        PAULI_X,
+        PAULI_Y,
+        PAULI_Z,
+        CNOT,
+        HADAMARD,
+        PHASE,
+        MEASURE,
+        SWAP,
+        CLIFFORD
+    };
+
+    /**
+     * A single operation of a compiled stabilizer circuit.
+     * The qubit operands are the 0-based indices of the qubit register as written in the QASM3 file.
+     * Operations acting on a single qubit leave qubit2 unused,
+     * except CLIFFORD which stores the code of its SingleQubitClifford in qubit2.
+     */
+    struct Instruction {
+        /**
+         * The gate to apply.
+         */
+        Gate gate;
+
+        /**
+         * First qubit operand, e.g. the control of a CNOT.
+         */
+        uint32_t qubit1;
+
+        /**
+         * Second qubit operand, e.g. the target of a CNOT, or the code of a CLIFFORD.
+         */
+        uint32_t qubit2;
+    };
+}
@@ -0,0 +1,117 @@
+#include "circuit_optimizer.h"
+#include "single_qubit_clifford.h"
+
+namespace CliffordTableaus {
+    namespace {
+        bool isTwoQubitGate(Gate gate) {
+            return gate == CNOT || gate == SWAP;
+        }
+
+        bool isSingleQubitGate(Gate gate) {
+            return !isTwoQubitGate(gate) && gate != MEASURE;
+        }
+
+        /**
+         * Express a merged single-qubit Clifford by a named gate if possible, since those have dedicated kernels.
+         */
+        Instruction toInstruction(uint32_t qubit, const SingleQubitClifford &clifford) {
+            for (auto gate: {HADAMARD, PHASE, PAULI_X, PAULI_Y, PAULI_Z}) {
+                if (SingleQubitClifford::fromInstruction({gate, qubit, 0}) == clifford) {
+                    return {gate, qubit, 0};
+                }
+            }
+            return {CLIFFORD, qubit, clifford.code()};
+        }
+    }
+
+    uint OptimizationStats::removed() const {
+        return gates_before - gates_after;
+    }
+
+    std::vector<Instruction> CircuitOptimizer::optimize(
+            uint n_qubits, const std::vector<Instruction> &instructions, OptimizationStats &stats
+    ) {
+        std::vector<Instruction> optimized;
+        std::vector<bool> alive;
+        optimized.reserve(instructions.size());
+        alive.reserve(instructions.size());
+        // Indices into optimized of the alive instructions acting on every qubit, the latest on top.
+        std::vector<std::vector<uint>> stacks(n_qubits);
+
+        auto top = [&](uint32_t qubit) -> Instruction * {
+            return stacks[qubit].empty() ? nullptr : &optimized[stacks[qubit].back()];
+        };
+        auto push = [&](const Instruction &instruction) {
+            stacks[instruction.qubit1].push_back(optimized.size());
+            if (isTwoQubitGate(instruction.gate)) {
+                stacks[instruction.qubit2].push_back(optimized.size());
+            }
+            optimized.push_back(instruction);
+            alive.push_back(true);
+        };
+        auto drop_top = [&](uint32_t qubit) {
+            const auto &dropped = *top(qubit);
+            alive[stacks[qubit].back()] = false;
+            if (isTwoQubitGate(dropped.gate)) {
+                stacks[dropped.qubit1].pop_back();
+                stacks[dropped.qubit2].pop_back();
+            } else {
+                stacks[qubit].pop_back();
+            }
+        };
+
+        for (const auto &instruction: instructions) {
+            auto two_qubit = isTwoQubitGate(instruction.gate);
+            if (instruction.qubit1 >= n_qubits ||
+                (two_qubit && (instruction.qubit2 >= n_qubits || instruction.qubit1 == instruction.qubit2))) {
+                optimized.push_back(instruction);
+                alive.push_back(true);
+                continue;
+            }
+
+            if (two_qubit) {
+                auto *previous = top(instruction.qubit1);
+                auto same_operands = previous != nullptr && previous == top(instruction.qubit2) &&
+                                     previous->gate == instruction.gate &&
+                                     (previous->qubit1 == instruction.qubit1 || instruction.gate == SWAP);
+                if (same_operands) {
+                    drop_top(instruction.qubit1);
+                } else {
+                    push(instruction);
+                }
+            } else if (instruction.gate == MEASURE) {
+                push(instruction);
+            } else if (instruction.gate != IDENTITY) {
+                auto *previous = top(instruction.qubit1);
+                if (previous == nullptr || !isSingleQubitGate(previous->gate)) {
+                    push(instruction);
+                    continue;
+                }
+                auto merged = SingleQubitClifford::fromInstruction(*previous).then(
+                        SingleQubitClifford::fromInstruction(instruction)
+                );
+                if (merged.isIdentity()) {
+                    drop_top(instruction.qubit1);
+                } else {
+                    *previous = toInstruction(instruction.qubit1, merged);
+                }
+            }
+        }
+
+        std::vector<Instruction> result;
+        result.reserve(optimized.size());
+        for (uint k = 0; k < optimized.size(); ++k) {
+            if (alive[k]) {
+                result.push_back(optimized[k]);
+            }
+        }
+        stats.gates_before = instructions.size();
+        stats.gates_after = result.size();
+        return result;
+    }
+
+    std::vector<Instruction> CircuitOptimizer::optimize(uint n_qubits, const std::vector<Instruction> &instructions) {
+        OptimizationStats stats;
+        return optimize(n_qubits, instructions, stats);
+    }
+}
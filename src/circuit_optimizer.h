@@ -0,0 +1,72 @@
+#pragma once
+
+#include "circuit_instruction.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace CliffordTableaus {
+    using uint = std::size_t;
+
+    /**
+     * Number of gates of a circuit before and after optimization.
+     */
+    struct OptimizationStats {
+        /**
+         * The number of instructions of the parsed circuit.
+         */
+        uint gates_before = 0;
+
+        /**
+         * The number of instructions left after optimization.
+         */
+        uint gates_after = 0;
+
+        /**
+         * Get the number of instructions removed by the optimization.
+         * @return gates_before - gates_after.
+         */
+        [[nodiscard]] uint removed() const;
+    };
+
+    /**
+     * Peephole optimizer for compiled stabilizer circuits.
+     * A single pass keeps, for every qubit, a stack of the optimized instructions acting on it.
+     * A new instruction only interacts with the instructions on top of the stacks of its qubits,
+     * since nothing acting on these qubits can have been applied after them:
+     * <ul>
+     *   <li>Identity gates are dropped.</li>
+     *   <li>Single-qubit gates are merged into the single-qubit gate on top of the stack,
+     *       and both are dropped if they compose to the identity.</li>
+     *   <li>A CNOT or SWAP cancels with an identical gate on top of the stacks of both of its qubits.</li>
+     *   <li>Measurements are barriers.</li>
+     * </ul>
+     * Dropping an instruction uncovers the instruction below it, so cancellations cascade,
+     * e.g. h q[0]; cx q[0], q[1]; cx q[0], q[1]; h q[0]; is removed entirely.
+     * Merged gates are emitted as CLIFFORD instructions, unless they equal one of the named gates.
+     * Instructions with invalid qubit indices are kept as they are and do not take part in the optimization.
+     * The optimized circuit applies the same gates to the tableau, but it no longer touches every qubit the
+     * original circuit touched, so callers must derive the unmeasured qubits from the original instructions.
+     */
+    class CircuitOptimizer {
+    public:
+        /**
+         * Optimize a circuit.
+         * @param n_qubits Number of qubits of the circuit.
+         * @param instructions Instructions of the circuit in order of execution.
+         * @param stats Receives the number of gates before and after optimization.
+         * @return The optimized instructions in order of execution.
+         */
+        static std::vector<Instruction> optimize(
+                uint n_qubits, const std::vector<Instruction> &instructions, OptimizationStats &stats
+        );
+
+        /**
+         * Optimize a circuit.
+         * @param n_qubits Number of qubits of the circuit.
+         * @param instructions Instructions of the circuit in order of execution.
+         * @return The optimized instructions in order of execution.
+         */
+        static std::vector<Instruction> optimize(uint n_qubits, const std::vector<Instruction> &instructions);
+    };
+}
@@ -0,0 +1,209 @@
+#include "compiled_circuit.h"
+#include "stabilizer_circuit.h"
+#include "binary_circuit.h"
+#include "instrumentation.h"
+#include "stim_a_fast_stabilizer_circuit_simulator/frame_simulator.h"
+
+#include <algorithm>
+#include <span>
+#include <stdexcept>
+#include <utility>
+
+namespace CliffordTableaus {
+    CompiledCircuit::CompiledCircuit(uint p_n, std::vector<Instruction> p_instructions)
+            : n(p_n), program(CircuitOptimizer::optimize(n, p_instructions, optimization_stats)) {
+        buildLayers();
+        findMeasureAll();
+        // Replay the marking of StabilizerCircuit::applyInstruction on the original circuit.
+        std::string measured(n, 'x');
+        for (const auto &instruction: p_instructions) {
+            if (instruction.gate == MEASURE && instruction.qubit1 < n) {
+                measured[instruction.qubit1] = '0';
+            } else if (instruction.qubit1 < n && ((instruction.gate != CNOT && instruction.gate != SWAP) ||
+                                                  instruction.qubit2 < n)) {
+                StabilizerCircuit::markUnmeasured(instruction, measured);
+            }
+        }
+        for (uint32_t q = 0; q < n; ++q) {
+            if (measured[q] == 'x') {
+                unmeasured_qubits.push_back(q);
+            }
+        }
+    }
+
+    void CompiledCircuit::buildLayers() {
+        // Greedily extend the current layer until an instruction touches a qubit which is already in use.
+        layer_ends.clear();
+        std::vector<uint> layer_of_qubit(n, 0);
+        uint layer = 1;
+        uint layer_start = 0;
+        auto close_layer = [&](uint end) {
+            layer_ends.push_back(end);
+            layer_start = end;
+            ++layer;
+        };
+        for (uint k = 0; k < program.size(); ++k) {
+            const auto &instruction = program[k];
+            auto two_qubit = instruction.gate == CNOT || instruction.gate == SWAP;
+            auto isolated = instruction.gate == MEASURE || instruction.qubit1 >= n ||
+                            (two_qubit && instruction.qubit2 >= n);
+            auto conflict = isolated || layer_of_qubit[instruction.qubit1] == layer ||
+                            (two_qubit && layer_of_qubit[instruction.qubit2] == layer);
+            if (k > layer_start && conflict) {
+                close_layer(k);
+            }
+            if (isolated) {
+                close_layer(k + 1);
+                continue;
+            }
+            layer_of_qubit[instruction.qubit1] = layer;
+            if (two_qubit) {
+                layer_of_qubit[instruction.qubit2] = layer;
+            }
+        }
+        if (layer_start < program.size()) {
+            layer_ends.push_back(program.size());
+        }
+    }
+
+    void CompiledCircuit::findMeasureAll() {
+        std::vector<bool> measured(n, false);
+        uint measured_qubits = 0;
+        auto begin = program.size();
+        while (begin > 0 && program[begin - 1].gate == MEASURE && program[begin - 1].qubit1 < n) {
+            --begin;
+            if (!measured[program[begin].qubit1]) {
+                measured[program[begin].qubit1] = true;
+                ++measured_qubits;
+            }
+        }
+        // Measuring a qubit again yields the same outcome, so repeated measurements within the block are covered too.
+        measure_all_begin = n > 0 && measured_qubits == n ? begin : program.size();
+    }
+
+    void CompiledCircuit::runProgram(StabilizerTableau &tableau, std::string &measurement_result, uint begin) const {
+        auto layer_end = std::upper_bound(layer_ends.begin(), layer_ends.end(), begin);
+        for (auto start = begin; start < program.size(); start = *layer_end++) {
+            const auto &instruction = program[start];
+            if (start >= measure_all_begin) {
+                // The prefix may already contain some measurements of the block, which MeasureAll reproduces.
+                auto outcomes = tableau.MeasureAll();
+                for (uint q = 0; q < n; ++q) {
+                    measurement_result[q] = static_cast<char>('0' + outcomes[q]);
+                }
+                break;
+            }
+            if (instruction.gate == MEASURE) {
+                uint8_t measurement = tableau.Measurement(instruction.qubit1 + 1);
+                measurement_result.at(instruction.qubit1) = static_cast<char>('0' + measurement);
+            } else if (*layer_end - start == 1) {
+                tableau.applyGate(instruction);
+            } else {
+                tableau.applyLayer(std::span<const Instruction>(program.data() + start, *layer_end - start));
+            }
+        }
+        for (auto q: unmeasured_qubits) {
+            measurement_result[q] = 'x';
+        }
+    }
+
+    CompiledCircuit CompiledCircuit::load(const std::string &circuit_filename) {
+        uint n_qubits;
+        std::vector<Instruction> parsed_instructions;
+        auto circuit_path = StabilizerCircuit::circuitFilePath(circuit_filename);
+        if (BinaryCircuit::isBinaryCircuit(circuit_path)) {
+            TABLEAU_STATS_PHASE(parse_timer, STATS_PARSE, 1);
+            BinaryCircuit::read(circuit_path, n_qubits, parsed_instructions);
+        } else if (!StabilizerCircuit::compileCircuit(circuit_filename, n_qubits, parsed_instructions)) {
+            throw std::runtime_error("Invalid QASM3 circuit: " + circuit_filename);
+        }
+        // The optimization and the layering run in the constructor.
+        TABLEAU_STATS_PHASE(compile_timer, STATS_COMPILE, 1);
+        return {n_qubits, std::move(parsed_instructions)};
+    }
+
+    std::string CompiledCircuit::run(StabilizerTableau &tableau, Rng &rng) const {
+        tableau.setRng(&rng);
+        auto measurement_result = run(tableau);
+        tableau.setRng(nullptr);
+        return measurement_result;
+    }
+
+    std::string CompiledCircuit::run(StabilizerTableau &tableau) const {
+        tableau.initializeTableau(n);
+        std::string measurement_result(n, 'x');
+        runProgram(tableau, measurement_result, 0);
+        return measurement_result;
+    }
+
+    OutcomeSpace CompiledCircuit::exactDistribution(StabilizerTableau &tableau) const {
+        tableau.initializeTableau(n);
+        std::vector<bool> measured(n, false);
+        std::vector<uint32_t> measured_qubits;
+        for (const auto &instruction: program) {
+            if (instruction.gate == MEASURE) {
+                if (instruction.qubit1 < n && !measured[instruction.qubit1]) {
+                    measured[instruction.qubit1] = true;
+                    measured_qubits.push_back(instruction.qubit1);
+                }
+                continue;
+            }
+            auto two_qubit = instruction.gate == CNOT || instruction.gate == SWAP;
+            auto after_measurement = (instruction.qubit1 < n && measured[instruction.qubit1]) ||
+                                     (two_qubit && instruction.qubit2 < n && measured[instruction.qubit2]);
+            if (after_measurement && instruction.gate != IDENTITY) {
+                // Any shot serves as the reference of the frames, its outcomes do not matter.
+                Rng rng(0);
+                return FrameSimulator(*this, run(tableau, rng)).outcomeSpace();
+            }
+            tableau.applyGate(instruction);
+        }
+
+        // Qubits reported as unmeasured are marginalized, even if the optimization removed their later gates.
+        for (auto q: unmeasured_qubits) {
+            measured[q] = false;
+        }
+        std::erase_if(measured_qubits, [&](uint32_t q) { return !measured[q]; });
+        auto distribution = tableau.outcomeSpace();
+        distribution.restrict(measured_qubits);
+        return distribution;
+    }
+
+    CircuitPrefix CompiledCircuit::simulatePrefix(StabilizerTableau &tableau) const {
+        CircuitPrefix prefix;
+        tableau.initializeTableau(n);
+        prefix.measurement_result = std::string(n, 'x');
+        for (const auto &instruction: program) {
+            // Determinate measurements yield the same outcome in every shot and belong to the prefix.
+            if (instruction.gate == MEASURE && tableau.hasRandomOutcome(instruction.qubit1 + 1)) {
+                break;
+            }
+            StabilizerCircuit::applyInstruction(instruction, tableau, prefix.measurement_result);
+            ++prefix.length;
+        }
+        tableau.saveSnapshot(prefix.snapshot);
+        return prefix;
+    }
+
+    std::string CompiledCircuit::runFromPrefix(const CircuitPrefix &prefix, StabilizerTableau &tableau,
+                                               Rng &rng) const {
+        tableau.restoreSnapshot(prefix.snapshot);
+        tableau.setRng(&rng);
+        auto measurement_result = prefix.measurement_result;
+        runProgram(tableau, measurement_result, prefix.length);
+        tableau.setRng(nullptr);
+        return measurement_result;
+    }
+
+    uint CompiledCircuit::qubits() const {
+        return n;
+    }
+
+    const std::vector<Instruction> &CompiledCircuit::getProgram() const {
+        return program;
+    }
+
+    const OptimizationStats &CompiledCircuit::optimizationStats() const {
+        return optimization_stats;
+    }
+}
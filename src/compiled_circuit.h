@@ -0,0 +1,322 @@
+#pragma once
+
+#include "stabilizer_tableau.h"
+#include "circuit_instruction.h"
+#include "circuit_optimizer.h"
+#include "single_qubit_clifford.h"
+#include "improved_simulation_of_stabilizer_circuits/subroutines.h"
+
+#include <algorithm>
+#include <concepts>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace CliffordTableaus {
+    using uint = std::size_t;
+
+    /**
+     * A tableau type of which the gates can be called directly, i.e. a subclass of StabilizerTableau implementing all
+     * of them. CompiledCircuit is instantiated for such types to execute shots without virtual calls.
+     */
+    template<class TableauT>
+    concept ConcreteTableau = std::derived_from<TableauT, StabilizerTableau> && !std::is_abstract_v<TableauT>;
+
+    /**
+     * The state reached by the deterministic prefix of a circuit, see CompiledCircuit::simulatePrefix.
+     */
+    struct CircuitPrefix {
+        /**
+         * The number of instructions of the program (see CompiledCircuit::getProgram) covered by the prefix.
+         */
+        uint length{};
+
+        /**
+         * The tableau after the prefix.
+         */
+        TableauSnapshot snapshot;
+
+        /**
+         * The measurement result after the prefix, containing the outcomes of its determinate measurements.
+         */
+        std::string measurement_result;
+    };
+
+    /**
+     * A stabilizer circuit which has been loaded and parsed once and can be executed for any number of shots.
+     * Executing a shot only performs tableau work, the circuit file is never touched again.
+     */
+    class CompiledCircuit {
+    private:
+        /**
+         * The number of qubits declared by the circuit.
+         */
+        uint n{};
+
+        /**
+         * Number of gates before and after the optimization.
+         */
+        OptimizationStats optimization_stats;
+
+        /**
+         * The instructions which are actually executed: the instructions of the circuit after the peephole
+         * optimization of CircuitOptimizer, which also fuses every run of single-qubit gates on the same qubit.
+         */
+        std::vector<Instruction> program;
+
+        /**
+         * The 0-based indices of the qubits which are not measured after the last gate acting on them
+         * in the original circuit. They are reported as 'x' even if the optimization removed all of their gates.
+         */
+        std::vector<uint32_t> unmeasured_qubits;
+
+        /**
+         * The program is split into layers of gates acting on disjoint qubits, which are applied at once.
+         * Every entry is the index one past the last instruction of a layer.
+         * Measurements always form a layer of their own.
+         */
+        std::vector<uint> layer_ends;
+
+        /**
+         * Index of the first instruction of the block of measurements ending the program if the block measures
+         * every qubit, as it does in the generated circuits. The block is executed with a single
+         * StabilizerTableau::MeasureAll. Equal to the size of the program if there is no such block.
+         */
+        uint measure_all_begin{};
+
+        /**
+         * Find the block of measurements ending the program and set measure_all_begin.
+         */
+        void findMeasureAll();
+
+        /**
+         * Split the program into layers.
+         */
+        void buildLayers();
+
+        /**
+         * Execute the program starting at the given instruction and mark the unmeasured qubits.
+         * @param tableau Stabilizer tableau to use to execute the circuit.
+         * @param measurement_result String with running measurement results.
+         * @param begin Index of the first instruction of the program to execute.
+         */
+        void runProgram(StabilizerTableau &tableau, std::string &measurement_result, uint begin) const;
+
+        /**
+         * Apply the unitary gate of a compiled instruction, calling the gate of TableauT directly.
+         * @param tableau Stabilizer tableau to apply the gate to.
+         * @param instruction Instruction to apply.
+         */
+        template<ConcreteTableau TableauT>
+        static void applyGate(TableauT &tableau, const Instruction &instruction);
+
+        /**
+         * Execute the program like runProgram, but with all gates and measurements bound to TableauT at compile time,
+         * so that they can be inlined into the loop over the program.
+         * @param tableau Stabilizer tableau to use to execute the circuit.
+         * @param measurement_result String with running measurement results.
+         * @param begin Index of the first instruction of the program to execute.
+         */
+        template<ConcreteTableau TableauT>
+        void runProgram(TableauT &tableau, std::string &measurement_result, uint begin) const;
+
+    public:
+        /**
+         * Construct a new CompiledCircuit object from already parsed instructions.
+         * Only the optimized program is kept, the parsed instructions are released once it is built.
+         * @param p_n Number of qubits of the circuit.
+         * @param p_instructions The instructions of the circuit in order of execution.
+         */
+        CompiledCircuit(uint p_n, std::vector<Instruction> p_instructions);
+
+        /**
+         * Load and parse the stabilizer circuit given by the QASM3 code in the file given by circuit_filename.
+         * Files in the binary format of BinaryCircuit are detected by their magic number and loaded directly.
+         * Throws a runtime error if the file does not exist or does not contain a valid QASM3 header.
+         * @param circuit_filename File containing the circuit in QASM3 format.
+         * @return The compiled circuit.
+         */
+        static CompiledCircuit load(const std::string &circuit_filename);
+
+        /**
+         * Execute one shot of the circuit using the provided stabilizer tableau.
+         * @param tableau Stabilizer tableau to use to execute the circuit.
+         * @param rng Generator of the random measurement outcomes of this shot.
+         * @return The final measurement of the executed circuit
+         * using '0' and '1' for measured qubits and 'x' for unmeasured qubits.
+         */
+        std::string run(StabilizerTableau &tableau, Rng &rng) const;
+
+        /**
+         * Execute one shot of the circuit using a tableau of a concrete type.
+         * The shot is instantiated for the type and executed without virtual calls,
+         * whereas tableaus only known as StabilizerTableau use the overload above.
+         * @param tableau Stabilizer tableau to use to execute the circuit.
+         * @param rng Generator of the random measurement outcomes of this shot.
+         * @return The final measurement of the executed circuit
+         * using '0' and '1' for measured qubits and 'x' for unmeasured qubits.
+         */
+        template<ConcreteTableau TableauT>
+        std::string run(TableauT &tableau, Rng &rng) const;
+
+        /**
+         * Execute one shot of the circuit drawing random measurement outcomes from the tableau's generator.
+         * @param tableau Stabilizer tableau to use to execute the circuit.
+         * @return The final measurement of the executed circuit
+         * using '0' and '1' for measured qubits and 'x' for unmeasured qubits.
+         */
+        std::string run(StabilizerTableau &tableau) const;
+
+        /**
+         * Simulate the longest prefix of the circuit that ends before the first measurement with a random outcome.
+         * Every shot passes through exactly the same state at the end of this prefix,
+         * so it only needs to be simulated once and can be restored for every shot with runFromPrefix.
+         * @param tableau Stabilizer tableau to simulate the prefix with. Holds the state after the prefix on return.
+         * @return The prefix, including a snapshot of the tableau.
+         */
+        CircuitPrefix simulatePrefix(StabilizerTableau &tableau) const;
+
+        /**
+         * Execute one shot of the circuit by restoring the state after the prefix and simulating only the remainder.
+         * @param prefix Prefix computed by simulatePrefix with a tableau of the same type.
+         * @param tableau Stabilizer tableau to use to execute the circuit.
+         * @param rng Generator of the random measurement outcomes of this shot.
+         * @return The final measurement of the executed circuit
+         * using '0' and '1' for measured qubits and 'x' for unmeasured qubits.
+         */
+        std::string runFromPrefix(const CircuitPrefix &prefix, StabilizerTableau &tableau, Rng &rng) const;
+
+        /**
+         * Execute one shot of the circuit from the prefix using a tableau of a concrete type without virtual calls.
+         * @param prefix Prefix computed by simulatePrefix with a tableau of the same type.
+         * @param tableau Stabilizer tableau to use to execute the circuit.
+         * @param rng Generator of the random measurement outcomes of this shot.
+         * @return The final measurement of the executed circuit
+         * using '0' and '1' for measured qubits and 'x' for unmeasured qubits.
+         */
+        template<ConcreteTableau TableauT>
+        std::string runFromPrefix(const CircuitPrefix &prefix, TableauT &tableau, Rng &rng) const;
+
+        /**
+         * Compute the exact distribution of the final measurement strings, which replaces sampling many shots.
+         * If no gate acts on a qubit after its first measurement, the measurements commute with all later gates
+         * and are deferred to the end of the circuit. Only the gates are simulated, the distribution is then derived
+         * from the stabilizers by StabilizerTableau::outcomeSpace and restricted to the qubits reported as measured.
+         * Other circuits, e.g. those reusing measured qubits, execute one reference shot and derive the distribution
+         * from its frames with FrameSimulator::outcomeSpace.
+         * @param tableau Stabilizer tableau to simulate the circuit with.
+         * @return The distribution of the measurement strings, using 'x' for unmeasured qubits.
+         */
+        OutcomeSpace exactDistribution(StabilizerTableau &tableau) const;
+
+        /**
+         * Get the number of qubits declared by the circuit.
+         * @return The number of qubits.
+         */
+        [[nodiscard]] uint qubits() const;
+
+        /**
+         * Get the instructions which are executed, i.e. the instructions after optimization.
+         * @return The executed instructions in order of execution.
+         */
+        [[nodiscard]] const std::vector<Instruction> &getProgram() const;
+
+        /**
+         * Get the number of gates of the circuit before and after optimization.
+         * @return The optimization statistics.
+         */
+        [[nodiscard]] const OptimizationStats &optimizationStats() const;
+    };
+
+    // The calls below are qualified with TableauT, which binds them statically even if TableauT is not final.
+    template<ConcreteTableau TableauT>
+    void CompiledCircuit::applyGate(TableauT &tableau, const Instruction &instruction) {
+        uint q_index1 = instruction.qubit1;
+        uint q_index2 = instruction.qubit2;
+        switch (instruction.gate) {
+            case IDENTITY:
+                tableau.Identity(q_index1 + 1);
+                break;
+            case PAULI_X:
+                tableau.TableauT::PauliX(q_index1 + 1);
+                break;
+            case PAULI_Y:
+                tableau.TableauT::PauliY(q_index1 + 1);
+                break;
+            case PAULI_Z:
+                tableau.TableauT::PauliZ(q_index1 + 1);
+                break;
+            case CNOT:
+                tableau.TableauT::CNOT(q_index1 + 1, q_index2 + 1);
+                break;
+            case HADAMARD:
+                tableau.TableauT::Hadamard(q_index1 + 1);
+                break;
+            case PHASE:
+                tableau.TableauT::Phase(q_index1 + 1);
+                break;
+            case SWAP:
+                tableau.TableauT::SWAP(q_index1 + 1, q_index2 + 1);
+                break;
+            case CLIFFORD:
+                tableau.TableauT::Clifford(q_index1 + 1, SingleQubitClifford::fromInstruction(instruction));
+                break;
+            case MEASURE:
+                throw std::invalid_argument("Measurements cannot be applied as a gate.");
+        }
+    }
+
+    template<ConcreteTableau TableauT>
+    void CompiledCircuit::runProgram(TableauT &tableau, std::string &measurement_result, uint begin) const {
+        // Tableaus which do not override applyLayer would only apply the layer gate by gate through virtual calls.
+        constexpr bool has_layer_kernel = !std::is_same_v<
+                decltype(&TableauT::applyLayer), decltype(&StabilizerTableau::applyLayer)
+        >;
+        auto layer_end = std::upper_bound(layer_ends.begin(), layer_ends.end(), begin);
+        for (auto start = begin; start < program.size(); start = *layer_end++) {
+            const auto &instruction = program[start];
+            if (start >= measure_all_begin) {
+                auto outcomes = tableau.TableauT::MeasureAll();
+                for (uint q = 0; q < n; ++q) {
+                    measurement_result[q] = static_cast<char>('0' + outcomes[q]);
+                }
+                break;
+            }
+            if (instruction.gate == MEASURE) {
+                uint8_t measurement = tableau.TableauT::Measurement(instruction.qubit1 + 1);
+                measurement_result.at(instruction.qubit1) = static_cast<char>('0' + measurement);
+            } else if (has_layer_kernel && *layer_end - start > 1) {
+                tableau.TableauT::applyLayer(std::span<const Instruction>(program.data() + start, *layer_end - start));
+            } else {
+                for (auto k = start; k < *layer_end; ++k) {
+                    applyGate(tableau, program[k]);
+                }
+            }
+        }
+        for (auto q: unmeasured_qubits) {
+            measurement_result[q] = 'x';
+        }
+    }
+
+    template<ConcreteTableau TableauT>
+    std::string CompiledCircuit::run(TableauT &tableau, Rng &rng) const {
+        tableau.setRng(&rng);
+        tableau.TableauT::initializeTableau(n);
+        std::string measurement_result(n, 'x');
+        runProgram(tableau, measurement_result, 0);
+        tableau.setRng(nullptr);
+        return measurement_result;
+    }
+
+    template<ConcreteTableau TableauT>
+    std::string CompiledCircuit::runFromPrefix(const CircuitPrefix &prefix, TableauT &tableau, Rng &rng) const {
+        tableau.TableauT::restoreSnapshot(prefix.snapshot);
+        tableau.setRng(&rng);
+        auto measurement_result = prefix.measurement_result;
+        runProgram(tableau, measurement_result, prefix.length);
+        tableau.setRng(nullptr);
+        return measurement_result;
+    }
+}
@@ -0,0 +1,522 @@
+#pragma once
+
+#include "instrumentation.h"
+#include "subroutines.h"
+#include "stabilizer_tableau.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <iostream>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace CliffordTableaus {
+    using uint = std::size_t;
+
+    /**
+     * The improved stabilizer tableau for at most N qubits with storage and loop bounds fixed at compile time.
+     * The generators live in std::arrays instead of a runtime-sized std::vector, and every generator consists of
+     * W = ceil(N / 64) x words and W z words, so all loops over the words of a generator have a constant trip count
+     * and are unrolled by the compiler. The x words, z words and phase bits of all generators are stored in three
+     * separate arrays, so the loops of the gates over the generators touch contiguous memory and vectorize.
+     * Only the first 2n generators (plus the scratch space) are used, n is chosen at runtime up to N.
+     * @tparam N The maximal number of qubits.
+     */
+    template<uint N>
+    class FixedStabilizerTableau : public StabilizerTableau {
+    public:
+        /**
+         * The number of 64-bit words holding the x (or z) bits of one generator.
+         */
+        static constexpr uint W = (N + 63) / 64;
+
+    private:
+        using Words = std::array<uint64_t, W>;
+
+        /**
+         * The x words of the generators 1 to 2n + 1, generator i is stored at index i - 1.
+         */
+        std::array<Words, 2 * N + 1> xs{};
+
+        /**
+         * The z words of the generators 1 to 2n + 1, generator i is stored at index i - 1.
+         */
+        std::array<Words, 2 * N + 1> zs{};
+
+        /**
+         * The phase bits of the generators 1 to 2n + 1, generator i is stored at index i - 1.
+         */
+        std::array<uint8_t, 2 * N + 1> rs{};
+
+        /**
+         * Check a single-qubit gate operand and print a warning if it is invalid.
+         * @param qubit Index of the qubit.
+         * @param gate Name of the gate for the warning.
+         * @return Whether the qubit is valid.
+         */
+        bool check_qubit(uint qubit, const char *gate) const {
+            if (qubit == 0) {
+                std::cerr << "Warning: Attempted to apply " << gate << " with qubit = 0!" << std::endl;
+                return false;
+            }
+            if (qubit > n) {
+                std::cerr << "Warning: Attempted to apply " << gate << " with qubit > n!" << std::endl;
+                return false;
+            }
+            return true;
+        }
+
+        /**
+         * Check the indices of get_x, set_x, get_z and set_z.
+         * @param i Index of the generator.
+         * @param j Index of the qubit.
+         * @param message Message of the invalid argument exception.
+         */
+        void check_indices(uint i, uint j, const char *message) const {
+            if (i == 0 || j == 0 || i > 2 * n || j > n) {
+                throw std::invalid_argument(message);
+            }
+        }
+
+    protected:
+        /**
+         * The algorithm uses a subroutine called rowsum (h, i), which sets generator h equal to i + h,
+         * see ImprovedStabilizerTableau::rowsum.
+         * @param h The generator to update.
+         * @param i The generator to add to h.
+         */
+        void rowsum(uint h, uint i) {
+            TABLEAU_STATS_TIMER(timer, STATS_ROWSUM);
+            auto &x_h = xs[h - 1];
+            auto &z_h = zs[h - 1];
+            const auto &x_i = xs[i - 1];
+            const auto &z_i = zs[i - 1];
+            int sum_g = 2 * (rs[h - 1] + rs[i - 1]);
+            for (uint w = 0; w < W; ++w) {
+                // Same evaluation of g for all qubits of a word as in g_packed.
+                uint64_t pauli_x = x_i[w] & ~z_i[w];
+                uint64_t pauli_y = x_i[w] & z_i[w];
+                uint64_t pauli_z = ~x_i[w] & z_i[w];
+                uint64_t plus = (pauli_x & x_h[w] & z_h[w]) | (pauli_y & ~x_h[w] & z_h[w]) |
+                                (pauli_z & x_h[w] & ~z_h[w]);
+                uint64_t minus = (pauli_x & ~x_h[w] & z_h[w]) | (pauli_y & x_h[w] & ~z_h[w]) |
+                                 (pauli_z & x_h[w] & z_h[w]);
+                sum_g += std::popcount(plus) - std::popcount(minus);
+                x_h[w] ^= x_i[w];
+                z_h[w] ^= z_i[w];
+            }
+            sum_g = ((sum_g % 4) + 4) % 4;
+            if (sum_g == 0) {
+                rs[h - 1] = 0;
+            } else if (sum_g == 2) {
+                rs[h - 1] = 1;
+            } else {
+                throw std::logic_error("Sum_g should never be congruent to 1 or 3.");
+            }
+        }
+
+    public:
+        /**
+         * Construct a new FixedStabilizerTableau object.
+         */
+        FixedStabilizerTableau() = default;
+
+        /**
+         * Initialize the tableau to the state |0〉^(⊗n).
+         * Throws an invalid argument exception if n exceeds N.
+         * @param p_n Number of qubits in the system.
+         */
+        void initializeTableau(uint p_n) override {
+            if (p_n > N) {
+                throw std::invalid_argument("The tableau supports at most " + std::to_string(N) + " qubits.");
+            }
+            StabilizerTableau::initializeTableau(p_n, 0);
+            xs.fill({});
+            zs.fill({});
+            rs.fill(0);
+            for (uint j = 0; j < n; ++j) {
+                xs[j][j / 64] = uint64_t{1} << (j % 64);
+                zs[n + j][j / 64] = uint64_t{1} << (j % 64);
+            }
+        }
+
+        /// Superclass overrides begin.
+        void CNOT(uint control, uint target) override {
+            if (control == 0) {
+                std::cerr << "Attempted to apply CNOT with control = 0!" << std::endl;
+                return;
+            }
+            if (control > n) {
+                std::cerr << "Attempted to apply CNOT with control > n!" << std::endl;
+                return;
+            }
+            if (target == 0) {
+                std::cerr << "Attempted to apply CNOT with target = 0!" << std::endl;
+                return;
+            }
+            if (target > n) {
+                std::cerr << "Attempted to apply CNOT with target > n!" << std::endl;
+                return;
+            }
+            if (control == target) {
+                std::cerr << "Attempted to apply CNOT with target = control!" << std::endl;
+                return;
+            }
+            TABLEAU_STATS_TIMER(timer, STATS_CNOT);
+            auto word_a = (control - 1) / 64, shift_a = (control - 1) % 64;
+            auto word_b = (target - 1) / 64, shift_b = (target - 1) % 64;
+            for (uint i = 0; i < 2 * n; ++i) {
+                auto xia = (xs[i][word_a] >> shift_a) & 1;
+                auto zia = (zs[i][word_a] >> shift_a) & 1;
+                auto xib = (xs[i][word_b] >> shift_b) & 1;
+                auto zib = (zs[i][word_b] >> shift_b) & 1;
+                rs[i] ^= xia & zib & (xib ^ zia ^ 1);
+                xs[i][word_b] ^= xia << shift_b;
+                zs[i][word_a] ^= zib << shift_a;
+            }
+        }
+
+        void Hadamard(uint qubit) override {
+            if (qubit == 0) {
+                std::cerr << "Attempted to apply Hadamard with qubit = 0!" << std::endl;
+                return;
+            }
+            if (qubit > n) {
+                std::cerr << "Attempted to apply Hadamard with qubit > n!" << std::endl;
+                return;
+            }
+            TABLEAU_STATS_TIMER(timer, STATS_HADAMARD);
+            auto word = (qubit - 1) / 64;
+            auto mask = uint64_t{1} << ((qubit - 1) % 64);
+            for (uint i = 0; i < 2 * n; ++i) {
+                auto &x = xs[i][word];
+                auto &z = zs[i][word];
+                rs[i] ^= (x & z & mask) != 0;
+                auto differ = (x ^ z) & mask;
+                x ^= differ;
+                z ^= differ;
+            }
+        }
+
+        void Phase(uint qubit) override {
+            if (qubit == 0) {
+                std::cout << "Attempted to apply Phase with qubit = 0!" << std::endl;
+                return;
+            }
+            if (qubit > n) {
+                std::cout << "Attempted to apply Phase with qubit > n!" << std::endl;
+                return;
+            }
+            TABLEAU_STATS_TIMER(timer, STATS_PHASE);
+            auto word = (qubit - 1) / 64;
+            auto mask = uint64_t{1} << ((qubit - 1) % 64);
+            for (uint i = 0; i < 2 * n; ++i) {
+                rs[i] ^= (xs[i][word] & zs[i][word] & mask) != 0;
+                zs[i][word] ^= xs[i][word] & mask;
+            }
+        }
+
+        uint8_t Measurement(uint qubit) override {
+            if (qubit == 0) {
+                throw std::invalid_argument("Attempted to measure qubit = 0!");
+            }
+            if (qubit > n) {
+                throw std::invalid_argument("Attempted to measure qubit > n!");
+            }
+            TABLEAU_STATS_TIMER(timer, STATS_DETERMINATE_MEASUREMENT);
+            // See ImprovedStabilizerTableau::Measurement for the steps of the algorithm.
+            auto word = (qubit - 1) / 64;
+            auto mask = uint64_t{1} << ((qubit - 1) % 64);
+            uint p;
+            for (p = n + 1; p <= 2 * n; ++p) {
+                if (xs[p - 1][word] & mask) {
+                    break;
+                }
+            }
+            if (p <= 2 * n) {
+                // Case I: The outcome is random.
+                TABLEAU_STATS_RECLASSIFY(timer, STATS_RANDOM_MEASUREMENT);
+                for (uint i = 1; i <= 2 * n; ++i) {
+                    if (i != p && i != p - n && (xs[i - 1][word] & mask)) {
+                        rowsum(i, p);
+                    }
+                }
+                xs[p - n - 1] = xs[p - 1];
+                zs[p - n - 1] = zs[p - 1];
+                rs[p - n - 1] = rs[p - 1];
+                xs[p - 1].fill(0);
+                zs[p - 1].fill(0);
+                zs[p - 1][word] = mask;
+                rs[p - 1] = randomBit();
+                return rs[p - 1];
+            }
+
+            // Case II: The outcome is determinate.
+            auto scratch = 2 * n + 1;
+            xs[scratch - 1].fill(0);
+            zs[scratch - 1].fill(0);
+            rs[scratch - 1] = 0;
+            for (uint i = 1; i <= n; ++i) {
+                if (xs[i - 1][word] & mask) {
+                    rowsum(scratch, i + n);
+                }
+            }
+            return rs[scratch - 1];
+        }
+
+        std::vector<uint8_t> MeasureAll() override {
+            TABLEAU_STATS_TIMER(timer, STATS_MEASURE_ALL);
+            // See ImprovedStabilizerTableau::MeasureAll.
+            std::vector<uint64_t> stabilizers;
+            stabilizers.reserve(n * (2 * W + 1));
+            for (uint i = n; i < 2 * n; ++i) {
+                stabilizers.insert(stabilizers.end(), xs[i].begin(), xs[i].end());
+                stabilizers.insert(stabilizers.end(), zs[i].begin(), zs[i].end());
+                stabilizers.push_back(rs[i]);
+            }
+            auto outcomes = sampleMeasureAll(stabilizers, W);
+            initializeTableau(n);
+            std::copy(outcomes.begin(), outcomes.end(), rs.begin() + n);
+            return outcomes;
+        }
+
+        OutcomeSpace outcomeSpace() override {
+            std::vector<uint64_t> stabilizers;
+            stabilizers.reserve(n * (2 * W + 1));
+            for (uint i = n; i < 2 * n; ++i) {
+                stabilizers.insert(stabilizers.end(), xs[i].begin(), xs[i].end());
+                stabilizers.insert(stabilizers.end(), zs[i].begin(), zs[i].end());
+                stabilizers.push_back(rs[i]);
+            }
+            return reduceOutcomeSpace(stabilizers, W);
+        }
+
+        void PauliX(uint qubit) override {
+            if (!check_qubit(qubit, "Pauli-X")) {
+                return;
+            }
+            TABLEAU_STATS_TIMER(timer, STATS_PAULI_X);
+            // X anticommutes with Z and Y, so it flips the sign of every generator with zia = 1.
+            auto word = (qubit - 1) / 64;
+            auto shift = (qubit - 1) % 64;
+            for (uint i = 0; i < 2 * n; ++i) {
+                rs[i] ^= (zs[i][word] >> shift) & 1;
+            }
+        }
+
+        void PauliY(uint qubit) override {
+            if (!check_qubit(qubit, "Pauli-Y")) {
+                return;
+            }
+            TABLEAU_STATS_TIMER(timer, STATS_PAULI_Y);
+            // Y anticommutes with X and Z, so it flips the sign of every generator with xia ^ zia = 1.
+            auto word = (qubit - 1) / 64;
+            auto shift = (qubit - 1) % 64;
+            for (uint i = 0; i < 2 * n; ++i) {
+                rs[i] ^= ((xs[i][word] ^ zs[i][word]) >> shift) & 1;
+            }
+        }
+
+        void PauliZ(uint qubit) override {
+            if (!check_qubit(qubit, "Pauli-Z")) {
+                return;
+            }
+            TABLEAU_STATS_TIMER(timer, STATS_PAULI_Z);
+            // Z anticommutes with X and Y, so it flips the sign of every generator with xia = 1.
+            auto word = (qubit - 1) / 64;
+            auto shift = (qubit - 1) % 64;
+            for (uint i = 0; i < 2 * n; ++i) {
+                rs[i] ^= (xs[i][word] >> shift) & 1;
+            }
+        }
+
+        void SWAP(uint qubit1, uint qubit2) override {
+            if (qubit1 == 0) {
+                std::cerr << "Attempted to apply SWAP with qubit1 = 0!" << std::endl;
+                return;
+            }
+            if (qubit1 > n) {
+                std::cerr << "Attempted to apply SWAP with qubit1 > n!" << std::endl;
+                return;
+            }
+            if (qubit2 == 0) {
+                std::cerr << "Attempted to apply SWAP with qubit2 = 0!" << std::endl;
+                return;
+            }
+            if (qubit2 > n) {
+                std::cerr << "Attempted to apply SWAP with qubit2 > n!" << std::endl;
+                return;
+            }
+            if (qubit1 == qubit2) {
+                return;
+            }
+            TABLEAU_STATS_TIMER(timer, STATS_SWAP);
+            auto word1 = (qubit1 - 1) / 64, shift1 = (qubit1 - 1) % 64;
+            auto word2 = (qubit2 - 1) / 64, shift2 = (qubit2 - 1) % 64;
+            for (uint i = 0; i < 2 * n; ++i) {
+                for (auto *words: {&xs[i], &zs[i]}) {
+                    auto differ = (((*words)[word1] >> shift1) ^ ((*words)[word2] >> shift2)) & 1;
+                    (*words)[word1] ^= differ << shift1;
+                    (*words)[word2] ^= differ << shift2;
+                }
+            }
+        }
+
+        void Clifford(uint qubit, const SingleQubitClifford &clifford) override {
+            if (!check_qubit(qubit, "Clifford")) {
+                return;
+            }
+            TABLEAU_STATS_TIMER(timer, STATS_CLIFFORD);
+            auto word = (qubit - 1) / 64;
+            auto shift = (qubit - 1) % 64;
+            for (uint i = 0; i < 2 * n; ++i) {
+                auto xia = (xs[i][word] >> shift) & 1;
+                auto zia = (zs[i][word] >> shift) & 1;
+                auto image = clifford.image[(xia << 1) | zia];
+                rs[i] ^= image >> 2;
+                xs[i][word] ^= (xia ^ ((image >> 1) & 1u)) << shift;
+                zs[i][word] ^= (zia ^ (image & 1u)) << shift;
+            }
+        }
+
+        /**
+         * The snapshot holds the W x words, W z words and the phase bit of each of the 2n generators.
+         * @param snapshot Snapshot to overwrite.
+         */
+        void saveSnapshot(TableauSnapshot &snapshot) const override {
+            snapshot.n = n;
+            snapshot.total_bits = total_bits;
+            snapshot.words.resize(2 * n * (2 * W + 1));
+            auto word = snapshot.words.begin();
+            for (uint i = 0; i < 2 * n; ++i) {
+                word = std::copy(xs[i].begin(), xs[i].end(), word);
+                word = std::copy(zs[i].begin(), zs[i].end(), word);
+                *word++ = rs[i];
+            }
+        }
+
+        void restoreSnapshot(const TableauSnapshot &snapshot) override {
+            if (snapshot.n > N) {
+                throw std::invalid_argument("The tableau supports at most " + std::to_string(N) + " qubits.");
+            }
+            n = snapshot.n;
+            total_bits = snapshot.total_bits;
+            auto word = snapshot.words.begin();
+            for (uint i = 0; i < 2 * n; ++i) {
+                std::copy(word, word + W, xs[i].begin());
+                std::copy(word + W, word + 2 * W, zs[i].begin());
+                rs[i] = static_cast<uint8_t>(word[2 * W]);
+                word += 2 * W + 1;
+            }
+        }
+
+        bool hasRandomOutcome(uint qubit) override {
+            if (qubit == 0) {
+                throw std::invalid_argument("Attempted to measure qubit = 0!");
+            }
+            if (qubit > n) {
+                throw std::invalid_argument("Attempted to measure qubit > n!");
+            }
+            // Same check as the first step of Measurement.
+            auto word = (qubit - 1) / 64;
+            auto mask = uint64_t{1} << ((qubit - 1) % 64);
+            for (uint p = n + 1; p <= 2 * n; ++p) {
+                if (xs[p - 1][word] & mask) {
+                    return true;
+                }
+            }
+            return false;
+        }
+        /// Superclass overrides end.
+
+        /**
+         * Set the value of the x operator bit for a qubit.
+         * @param i Index of the generator.
+         * @param j Index of qubit.
+         * @param x Value of the x operator bit.
+         */
+        void set_x(uint i, uint j, uint8_t x) {
+            check_indices(i, j, "Invalid indices for set_x.");
+            auto &word = xs[i - 1][(j - 1) / 64];
+            word = (word & ~(uint64_t{1} << ((j - 1) % 64))) | (static_cast<uint64_t>(x & 1) << ((j - 1) % 64));
+        }
+
+        /**
+         * Set the value of the z operator bit for a qubit.
+         * @param i Index of the generator.
+         * @param j Index of qubit.
+         * @param z Value of the z operator bit.
+         */
+        void set_z(uint i, uint j, uint8_t z) {
+            check_indices(i, j, "Invalid indices for set_z.");
+            auto &word = zs[i - 1][(j - 1) / 64];
+            word = (word & ~(uint64_t{1} << ((j - 1) % 64))) | (static_cast<uint64_t>(z & 1) << ((j - 1) % 64));
+        }
+
+        /**
+         * Set the value of the phase operator bit for a qubit.
+         * @param i Index of the generator.
+         * @param r Value of the phase operator bit.
+         */
+        void set_r(uint i, uint8_t r) {
+            if (i == 0 || i > 2 * n) {
+                throw std::invalid_argument("Invalid index for set_r.");
+            }
+            rs[i - 1] = r & 1;
+        }
+
+        /**
+         * Get the value of the x operator bit for a qubit.
+         * @param i Index of the generator.
+         * @param j Index of qubit.
+         */
+        uint8_t get_x(uint i, uint j) {
+            check_indices(i, j, "Invalid indices for get_x.");
+            return (xs[i - 1][(j - 1) / 64] >> ((j - 1) % 64)) & 1;
+        }
+
+        /**
+         * Get the value of the z operator bit for a qubit.
+         * @param i Index of the generator.
+         * @param j Index of qubit.
+         */
+        uint8_t get_z(uint i, uint j) {
+            check_indices(i, j, "Invalid indices for get_z.");
+            return (zs[i - 1][(j - 1) / 64] >> ((j - 1) % 64)) & 1;
+        }
+
+        /**
+         * Get the value of the phase operator bit for a generator.
+         * @param i Index of the generator.
+         */
+        uint8_t get_r(uint i) {
+            if (i == 0 || i > 2 * n) {
+                throw std::invalid_argument("Invalid index for get_r.");
+            }
+            return rs[i - 1];
+        }
+    };
+
+    /**
+     * Create the smallest FixedStabilizerTableau for at least the given number of qubits.
+     * Instantiations exist for 64, 128 and 256 qubits.
+     * @param n_qubits Number of qubits of the circuit.
+     * @return The tableau, or nullptr if the circuit is too wide for all instantiations.
+     */
+    inline std::unique_ptr<StabilizerTableau> makeFixedStabilizerTableau(uint n_qubits) {
+        if (n_qubits <= 64) {
+            return std::make_unique<FixedStabilizerTableau<64>>();
+        }
+        if (n_qubits <= 128) {
+            return std::make_unique<FixedStabilizerTableau<128>>();
+        }
+        if (n_qubits <= 256) {
+            return std::make_unique<FixedStabilizerTableau<256>>();
+        }
+        return nullptr;
+    }
+}
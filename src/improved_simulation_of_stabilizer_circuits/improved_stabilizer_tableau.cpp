@@ -1,53 +1,52 @@
 #include "improved_stabilizer_tableau.h"
+#include "instrumentation.h"
+#include "stim_a_fast_stabilizer_circuit_simulator/simd_kernels.h"
+
+#include <algorithm>
+#include <bit>
 
 namespace CliffordTableaus {
     void ImprovedStabilizerTableau::initializeTableau(uint p_n) {
-        StabilizerTableau::initializeTableau(p_n, (2 * p_n + 1) * (2 * p_n + 1));
+        qubit_words = (p_n + 63) / 64;
+        row_words = 2 * qubit_words + 1;
+        pending_x.assign(qubit_words, 0);
+        pending_z.assign(qubit_words, 0);
+        paulis_pending = false;
+        StabilizerTableau::initializeTableau(p_n, (2 * p_n + 1) * row_words * 64);
         // The initial state |0〉^⊗n has ri = 0 for all i ∈ {1 to 2n + 1},
         // and xij = δij and zij = δ(i−n)j for all
         // i ∈ {1 to 2n + 1} and j ∈ {1 to n}.
+        // The storage is zero-initialized, so only the diagonals need to be set.
         for (uint i = 1; i <= n; ++i) {
-            set_x(i, i, 1);
-            set_z(n + i, i, 1);
-            set_r(i, 0);
-            set_r(n + i, 0);
-        }
-        using_scratch_space = true;
-        for (uint j = 1; j <= n; ++j) {
-            set_x(2 * n + 1, j, 0);
-            set_z(2 * n + 1, j, 0);
+            auto bit = uint64_t{1} << ((i - 1) % 64);
+            row(i)[(i - 1) / 64] = bit;
+            row(n + i)[qubit_words + (i - 1) / 64] = bit;
         }
-        set_r(2 * n + 1, 0);
-        using_scratch_space = false;
     }
 
 
     void ImprovedStabilizerTableau::rowsum(uint h, uint i) {
-        int rh = static_cast<int>(get_r(h));
-        int ri = static_cast<int>(get_r(i));
+        TABLEAU_STATS_TIMER(timer, STATS_ROWSUM);
+        auto row_h = row(h);
+        auto row_i = row(i);
+        auto rh = static_cast<int>(row_h[2 * qubit_words] & 1);
+        auto ri = static_cast<int>(row_i[2 * qubit_words] & 1);
 
-        int sum_g = 2 * (rh + ri);
-        for (uint j = 1; j <= n; ++j) {
-            int xij = static_cast<int>(get_x(i, j));
-            int zij = static_cast<int>(get_z(i, j));
-            int xhj = static_cast<int>(get_x(h, j));
-            int zhj = static_cast<int>(get_z(h, j));
-            sum_g += g(xij, zij, xhj, zhj);
-        }
+        auto &kernels = simd_kernels();
+        int sum_g = 2 * (rh + ri) +
+                    kernels.g_packed(row_i, row_i + qubit_words, row_h, row_h + qubit_words, qubit_words);
         sum_g = ((sum_g % 4) + 4) % 4;
 
         if (sum_g == 0) {
-            set_r(h, 0);
+            row_h[2 * qubit_words] = 0;
         } else if (sum_g == 2) {
-            set_r(h, 1);
+            row_h[2 * qubit_words] = 1;
         } else {
             throw std::logic_error("Sum_g should never be congruent to 1 or 3.");
         }
 
-        for (uint j = 1; j <= n; ++j) {
-            set_x(h, j, get_x(i, j) ^ get_x(h, j));
-            set_z(h, j, get_z(i, j) ^ get_z(h, j));
-        }
+        // The x and z words are adjacent, so both are XORed in one pass.
+        kernels.xor_words(row_h, row_i, 2 * qubit_words);
     }
 
     void ImprovedStabilizerTableau::CNOT(uint control, uint target) {
@@ -72,6 +71,8 @@ namespace CliffordTableaus {
             return;
         }
 
+        TABLEAU_STATS_TIMER(timer, STATS_CNOT);
+        flushPaulis();
         auto a = control;
         auto b = target;
         for (int i = 1; i <= 2 * n; ++i) {
@@ -93,6 +94,8 @@ namespace CliffordTableaus {
             return;
         }
 
+        TABLEAU_STATS_TIMER(timer, STATS_HADAMARD);
+        flushPaulis();
         auto a = qubit;
         for (uint i = 1; i <= 2 * n; ++i) {
             auto xia = get_x(i, a);
@@ -115,6 +118,8 @@ namespace CliffordTableaus {
             return;
         }
 
+        TABLEAU_STATS_TIMER(timer, STATS_PHASE);
+        flushPaulis();
         auto a = qubit;
         for (uint i = 1; i <= 2 * n; ++i) {
             set_r(i, get_r(i) ^ (get_x(i, a) & get_z(i, a)));
@@ -132,17 +137,19 @@ namespace CliffordTableaus {
             throw_invalid_argument("Attempted to measure qubit > n!");
         }
 
+        TABLEAU_STATS_TIMER(timer, STATS_DETERMINATE_MEASUREMENT);
+        flushPaulis();
+
         // Measurement of qubit a in standard basis.
         // First check whether there exists a p with n+1<=p<=2*n such that xpa=1.
+        // The indices are valid, so the x bits of qubit a are read directly from the rows.
         auto a = qubit;
-        uint p;
-        for (p = n + 1; p <= 2 * n; ++p) {
-            if (get_x(p, a) == 1) {
-                break;
-            }
-        }
+        auto word = (a - 1) / 64;
+        auto mask = uint64_t{1} << ((a - 1) % 64);
+        auto p = first_x_row(word, mask, n + 1);
         if (p <= 2 * n) {
             assert(p >= n + 1);
+            TABLEAU_STATS_RECLASSIFY(timer, STATS_RANDOM_MEASUREMENT);
 
             // The paper says the following:
             // Case I: Such a p exists.
@@ -161,26 +168,19 @@ namespace CliffordTableaus {
             for (uint i = 1; i <= 2 * n; ++i) {
                 if (i != p &&
                     i != p - n &&
-                    get_x(i, a) == 1) {
+                    (row(i)[word] & mask) != 0) {
                     rowsum(i, p);
                 }
             }
 
             // Second, set the entire (p−n)th row equal to the pth row.
-            for (uint j = 1; j <= n; ++j) {
-                set_x(p - n, j, get_x(p, j));
-                set_z(p - n, j, get_z(p, j));
-            }
-            set_r(p - n, get_r(p));
+            std::copy(row(p), row(p) + row_words, row(p - n));
 
             // Third, set the pth row to be identically 0,
             // except that rp is 0 or 1 with equal probability,
             // and zpa = 1.
-            for (uint j = 1; j <= n; ++j) {
-                set_x(p, j, 0);
-                set_z(p, j, 0);
-            }
-            set_r(p, random_bit());
+            std::fill(row(p), row(p) + row_words, 0);
+            set_r(p, randomBit());
             set_z(p, a, 1);
 
             // Finally, return rp as the measurement outcome.
@@ -192,62 +192,339 @@ namespace CliffordTableaus {
         // The only task is to determine whether 0 or 1 is observed.
         // This is done as follows.
         // First set the (2n+1)st row to be identically 0.
-        using_scratch_space = true;
-        for (int j = 1; j <= n; ++j) {
-            set_x(2 * n + 1, j, 0);
-            set_z(2 * n + 1, j, 0);
-        }
-        set_r(2 * n + 1, 0);
+        auto scratch = row(2 * n + 1);
+        std::fill(scratch, scratch + row_words, 0);
 
         // Second, call rowsum (2n+1,i+n) for all i ∈ {1 to n} such that xia = 1.
-        for (int i = 1; i <= n; ++i) {
-            if (get_x(i, a) == 1) {
+        for (uint i = 1; i <= n; ++i) {
+            if ((row(i)[word] & mask) != 0) {
                 rowsum(2 * n + 1, i + n);
             }
         }
 
         // Finally return r_{2n+1} as the measurement outcome.
-        auto measurement = get_r(2 * n + 1);
-        using_scratch_space = false;
-        return measurement;
+        return scratch[2 * qubit_words] & 1;
+    }
+
+    std::vector<uint8_t> ImprovedStabilizerTableau::MeasureAll() {
+        TABLEAU_STATS_TIMER(timer, STATS_MEASURE_ALL);
+        // The stabilizers are rows n + 1 to 2n, so they are reduced on a copy in the same layout.
+        flushPaulis();
+        std::vector<uint64_t> stabilizers(row(n + 1), row(2 * n + 1));
+        auto outcomes = sampleMeasureAll(stabilizers, qubit_words);
+
+        // The measured state is the basis state of the outcomes, whose stabilizers are the Zj with phase bit mj.
+        initializeTableau(n);
+        for (uint j = 1; j <= n; ++j) {
+            row(n + j)[2 * qubit_words] = outcomes[j - 1];
+        }
+        return outcomes;
+    }
+
+    OutcomeSpace ImprovedStabilizerTableau::outcomeSpace() {
+        flushPaulis();
+        std::vector<uint64_t> stabilizers(row(n + 1), row(2 * n + 1));
+        return reduceOutcomeSpace(stabilizers, qubit_words);
+    }
+
+    void ImprovedStabilizerTableau::PauliX(uint qubit) {
+        if (qubit == 0) {
+            std::cerr << "Warning: Attempted to apply Pauli-X with qubit = 0!" << std::endl;
+            return;
+        }
+        if (qubit > n) {
+            std::cerr << "Warning: Attempted to apply Pauli-X with qubit > n!" << std::endl;
+            return;
+        }
+
+        TABLEAU_STATS_TIMER(timer, STATS_PAULI_X);
+        // X anticommutes with Z and Y, so it will flip the sign of every generator with zia = 1.
+        pending_x[(qubit - 1) / 64] ^= uint64_t{1} << ((qubit - 1) % 64);
+        paulis_pending = true;
+    }
+
+    void ImprovedStabilizerTableau::PauliY(uint qubit) {
+        if (qubit == 0) {
+            std::cerr << "Warning: Attempted to apply Pauli-Y with qubit = 0!" << std::endl;
+            return;
+        }
+        if (qubit > n) {
+            std::cerr << "Warning: Attempted to apply Pauli-Y with qubit > n!" << std::endl;
+            return;
+        }
+
+        TABLEAU_STATS_TIMER(timer, STATS_PAULI_Y);
+        // Y anticommutes with X and Z, so it will flip the sign of every generator with xia ^ zia = 1.
+        pending_x[(qubit - 1) / 64] ^= uint64_t{1} << ((qubit - 1) % 64);
+        pending_z[(qubit - 1) / 64] ^= uint64_t{1} << ((qubit - 1) % 64);
+        paulis_pending = true;
+    }
+
+    void ImprovedStabilizerTableau::PauliZ(uint qubit) {
+        if (qubit == 0) {
+            std::cerr << "Warning: Attempted to apply Pauli-Z with qubit = 0!" << std::endl;
+            return;
+        }
+        if (qubit > n) {
+            std::cerr << "Warning: Attempted to apply Pauli-Z with qubit > n!" << std::endl;
+            return;
+        }
+
+        TABLEAU_STATS_TIMER(timer, STATS_PAULI_Z);
+        // Z anticommutes with X and Y, so it will flip the sign of every generator with xia = 1.
+        pending_z[(qubit - 1) / 64] ^= uint64_t{1} << ((qubit - 1) % 64);
+        paulis_pending = true;
+    }
+
+    void ImprovedStabilizerTableau::SWAP(uint qubit1, uint qubit2) {
+        if (qubit1 == 0) {
+            std::cerr << "Attempted to apply SWAP with qubit1 = 0!" << std::endl;
+            return;
+        }
+        if (qubit1 > n) {
+            std::cerr << "Attempted to apply SWAP with qubit1 > n!" << std::endl;
+            return;
+        }
+        if (qubit2 == 0) {
+            std::cerr << "Attempted to apply SWAP with qubit2 = 0!" << std::endl;
+            return;
+        }
+        if (qubit2 > n) {
+            std::cerr << "Attempted to apply SWAP with qubit2 > n!" << std::endl;
+            return;
+        }
+        if (qubit1 == qubit2) {
+            return;
+        }
+
+        TABLEAU_STATS_TIMER(timer, STATS_SWAP);
+        // Exchange the x and z bits of both qubits in every generator, the signs are unaffected.
+        // Pending Pauli gates move along with their qubits.
+        auto word1 = (qubit1 - 1) / 64;
+        auto word2 = (qubit2 - 1) / 64;
+        auto shift1 = (qubit1 - 1) % 64;
+        auto shift2 = (qubit2 - 1) % 64;
+        for (auto *pending: {&pending_x, &pending_z}) {
+            auto &w1 = (*pending)[word1];
+            auto &w2 = (*pending)[word2];
+            auto differ = ((w1 >> shift1) ^ (w2 >> shift2)) & 1;
+            w1 ^= differ << shift1;
+            w2 ^= differ << shift2;
+        }
+        for (uint i = 1; i <= 2 * n; ++i) {
+            auto row_i = row(i);
+            for (auto offset: {uint{0}, qubit_words}) {
+                auto &w1 = row_i[offset + word1];
+                auto &w2 = row_i[offset + word2];
+                auto differ = ((w1 >> shift1) ^ (w2 >> shift2)) & 1;
+                w1 ^= differ << shift1;
+                w2 ^= differ << shift2;
+            }
+        }
+    }
+
+    void ImprovedStabilizerTableau::Clifford(uint qubit, const SingleQubitClifford &clifford) {
+        if (qubit == 0) {
+            std::cerr << "Warning: Attempted to apply Clifford with qubit = 0!" << std::endl;
+            return;
+        }
+        if (qubit > n) {
+            std::cerr << "Warning: Attempted to apply Clifford with qubit > n!" << std::endl;
+            return;
+        }
+
+        TABLEAU_STATS_TIMER(timer, STATS_CLIFFORD);
+        flushPaulis();
+
+        // Replace the Pauli of every generator on the qubit by its image under the Clifford.
+        auto word = (qubit - 1) / 64;
+        auto shift = (qubit - 1) % 64;
+        for (uint i = 1; i <= 2 * n; ++i) {
+            auto row_i = row(i);
+            auto &x = row_i[word];
+            auto &z = row_i[qubit_words + word];
+            auto image = clifford.image[(((x >> shift) & 1) << 1) | ((z >> shift) & 1)];
+            row_i[2 * qubit_words] ^= image >> 2;
+            x = (x & ~(uint64_t{1} << shift)) | (uint64_t{(image >> 1) & 1u} << shift);
+            z = (z & ~(uint64_t{1} << shift)) | (uint64_t{image & 1u} << shift);
+        }
+    }
+
+    void ImprovedStabilizerTableau::applyLayer(std::span<const Instruction> layer) {
+        flushPaulis();
+        row_operations.clear();
+        for (const auto &instruction: layer) {
+            if (instruction.gate == MEASURE) {
+                throw std::invalid_argument("Measurements cannot be applied as a gate.");
+            }
+            auto two_qubit = instruction.gate == Gate::CNOT || instruction.gate == Gate::SWAP;
+            if (instruction.qubit1 >= n ||
+                (two_qubit && (instruction.qubit2 >= n || instruction.qubit1 == instruction.qubit2))) {
+                StabilizerTableau::applyLayer(layer);
+                return;
+            }
+            if (instruction.gate == IDENTITY) {
+                continue;
+            }
+            row_operations.push_back({
+                    two_qubit ? instruction.gate : CLIFFORD,
+                    instruction.qubit1 / 64, instruction.qubit1 % 64,
+                    instruction.qubit2 / 64, instruction.qubit2 % 64,
+                    two_qubit ? SingleQubitClifford::identity() : SingleQubitClifford::fromInstruction(instruction)
+            });
+        }
+
+        TABLEAU_STATS_TIMER(timer, STATS_LAYER);
+        if constexpr (Stats::enabled) {
+            for (const auto &instruction: layer) {
+                Stats::add(static_cast<StatsCounter>(instruction.gate));
+            }
+        }
+
+        for (uint i = 1; i <= 2 * n; ++i) {
+            auto row_i = row(i);
+            auto x = row_i;
+            auto z = row_i + qubit_words;
+            auto r = row_i[2 * qubit_words];
+            for (const auto &operation: row_operations) {
+                auto xa = (x[operation.word1] >> operation.shift1) & 1;
+                auto za = (z[operation.word1] >> operation.shift1) & 1;
+                if (operation.gate == CLIFFORD) {
+                    auto image = operation.clifford.image[(xa << 1) | za];
+                    r ^= image >> 2;
+                    x[operation.word1] ^= (xa ^ ((image >> 1) & 1u)) << operation.shift1;
+                    z[operation.word1] ^= (za ^ (image & 1u)) << operation.shift1;
+                    continue;
+                }
+                auto xb = (x[operation.word2] >> operation.shift2) & 1;
+                auto zb = (z[operation.word2] >> operation.shift2) & 1;
+                if (operation.gate == Gate::CNOT) {
+                    r ^= xa & zb & (xb ^ za ^ 1);
+                    x[operation.word2] ^= xa << operation.shift2;
+                    z[operation.word1] ^= zb << operation.shift1;
+                } else {
+                    x[operation.word1] ^= (xa ^ xb) << operation.shift1;
+                    x[operation.word2] ^= (xa ^ xb) << operation.shift2;
+                    z[operation.word1] ^= (za ^ zb) << operation.shift1;
+                    z[operation.word2] ^= (za ^ zb) << operation.shift2;
+                }
+            }
+            row_i[2 * qubit_words] = r;
+        }
+    }
+
+    void ImprovedStabilizerTableau::saveSnapshot(TableauSnapshot &snapshot) const {
+        StabilizerTableau::saveSnapshot(snapshot);
+        // The snapshot holds the state including the pending Pauli gates, which stay pending in this tableau.
+        if (paulis_pending) {
+            applyPendingPaulis(snapshot.words.data());
+        }
+    }
+
+    void ImprovedStabilizerTableau::restoreSnapshot(const TableauSnapshot &snapshot) {
+        StabilizerTableau::restoreSnapshot(snapshot);
+        qubit_words = (n + 63) / 64;
+        row_words = 2 * qubit_words + 1;
+        pending_x.assign(qubit_words, 0);
+        pending_z.assign(qubit_words, 0);
+        paulis_pending = false;
+    }
+
+    bool ImprovedStabilizerTableau::hasRandomOutcome(uint qubit) {
+        if (qubit == 0) {
+            throw_invalid_argument("Attempted to measure qubit = 0!");
+        }
+        if (qubit > n) {
+            throw_invalid_argument("Attempted to measure qubit > n!");
+        }
+        // Same check as the first step of Measurement.
+        return first_x_row((qubit - 1) / 64, uint64_t{1} << ((qubit - 1) % 64), n + 1) <= 2 * n;
+    }
+
+    void ImprovedStabilizerTableau::applyPendingPaulis(uint64_t *words) const {
+        // Only the words holding a pending gate contribute to the parity.
+        active_words.clear();
+        for (uint w = 0; w < qubit_words; ++w) {
+            if ((pending_x[w] | pending_z[w]) != 0) {
+                active_words.push_back(w);
+            }
+        }
+        // The sign of a generator flips if it anticommutes with the pending Pauli,
+        // i.e. if the parity of x·pending_z + z·pending_x is odd.
+        for (uint i = 0; i < 2 * n; ++i) {
+            auto row_i = words + i * row_words;
+            uint64_t anticommuting = 0;
+            for (auto w: active_words) {
+                anticommuting ^= (row_i[w] & pending_z[w]) ^ (row_i[qubit_words + w] & pending_x[w]);
+            }
+            row_i[2 * qubit_words] ^= std::popcount(anticommuting) & 1;
+        }
+    }
+
+    void ImprovedStabilizerTableau::flushPaulis() {
+        if (!paulis_pending) {
+            return;
+        }
+        applyPendingPaulis(tableau.data());
+        std::fill(pending_x.begin(), pending_x.end(), 0);
+        std::fill(pending_z.begin(), pending_z.end(), 0);
+        paulis_pending = false;
+    }
+
+    uint ImprovedStabilizerTableau::first_x_row(uint word, uint64_t mask, uint first) {
+        auto x = row(first) + word;
+        auto i = first;
+        while (i <= 2 * n && (*x & mask) == 0) {
+            x += row_words;
+            ++i;
+        }
+        return i;
+    }
+
+    uint64_t *ImprovedStabilizerTableau::row(uint i) {
+        // Shift the index starting at 1 to index starting at 0
+        return tableau.data() + (i - 1) * row_words;
     }
 
     void ImprovedStabilizerTableau::set(uint index, uint8_t value) {
-        uint byte_index = index / 8;
-        uint bit_index = index % 8;
-        tableau[byte_index] &= ~(1 << bit_index);
-        tableau[byte_index] |= value << bit_index;
+        uint word_index = index / 64;
+        uint bit_index = index % 64;
+        tableau[word_index] &= ~(uint64_t{1} << bit_index);
+        tableau[word_index] |= static_cast<uint64_t>(value & 1) << bit_index;
     }
 
     uint8_t ImprovedStabilizerTableau::get(uint index) {
-        uint byte_index = index / 8;
-        uint bit_index = index % 8;
-        return (tableau[byte_index] >> bit_index) & 1;
+        uint word_index = index / 64;
+        uint bit_index = index % 64;
+        return (tableau[word_index] >> bit_index) & 1;
     }
 
 
     void ImprovedStabilizerTableau::set_x(uint i, uint j, uint8_t x) {
+        flushPaulis();
         if (i == 0 || j == 0 || i > 2 * n || j > n) {
             throw_invalid_argument("Invalid indices for set_x.");
         }
         // Shift the index starting at 1 to index starting at 0
-        set((i - 1) * (2 * n + 1) + (j - 1), x);
+        set((i - 1) * row_words * 64 + (j - 1), x);
     }
 
     void ImprovedStabilizerTableau::set_z(uint i, uint j, uint8_t z) {
+        flushPaulis();
         if (i == 0 || j == 0 || i > 2 * n || j > n) {
             throw_invalid_argument("Invalid indices for set_z.");
         }
         // Shift the index starting at 1 to index starting at 0
-        set((i - 1) * (2 * n + 1) + n + (j - 1), z);
+        set(((i - 1) * row_words + qubit_words) * 64 + (j - 1), z);
     }
 
     void ImprovedStabilizerTableau::set_r(uint i, uint8_t r) {
+        flushPaulis();
         if (i == 0 || i > 2 * n) {
             throw_invalid_argument("Invalid index for set_r.");
         }
         // Shift the index starting at 1 to index starting at 0
-        set((i - 1) * (2 * n + 1) + 2 * n, r);
+        set(((i - 1) * row_words + 2 * qubit_words) * 64, r);
     }
 
     uint8_t ImprovedStabilizerTableau::get_x(uint i, uint j) {
@@ -255,7 +532,7 @@ namespace CliffordTableaus {
             throw_invalid_argument("Invalid indices for get_x.");
         }
         // Shift the index starting at 1 to index starting at 0
-        return get((i - 1) * (2 * n + 1) + (j - 1));
+        return get((i - 1) * row_words * 64 + (j - 1));
     }
 
     uint8_t ImprovedStabilizerTableau::get_z(uint i, uint j) {
@@ -263,20 +540,19 @@ namespace CliffordTableaus {
             throw_invalid_argument("Invalid indices for get_z.");
         }
         // Shift the index starting at 1 to index starting at 0
-        return get((i - 1) * (2 * n + 1) + n + (j - 1));
+        return get(((i - 1) * row_words + qubit_words) * 64 + (j - 1));
     }
 
     uint8_t ImprovedStabilizerTableau::get_r(uint i) {
+        flushPaulis();
         if (i == 0 || i > 2 * n) {
             throw_invalid_argument("Invalid index for get_r.");
         }
         // Shift the index starting at 1 to index starting at 0
-        return get((i - 1) * (2 * n + 1) + 2 * n);
+        return get(((i - 1) * row_words + 2 * qubit_words) * 64);
     }
 
     void ImprovedStabilizerTableau::throw_invalid_argument(const std::string &message) const {
-        if (!using_scratch_space) {
-            throw std::invalid_argument(message);
-        }
+        throw std::invalid_argument(message);
     }
 }
@@ -20,24 +20,100 @@ namespace CliffordTableaus {
      * For in addition to the n stabilizer generators, we now store n “destabilizer” generators,
      * which are Pauli operators that together with the stabilizer generators generate the full Pauli group Pn.
      * So the number of bits needed is 2*n*(2*n+1)=4*n^2+2*n.
+     * The generators are stored row-major with every row padded to whole 64-bit words:
+     * first the x words, then the z words, then one word holding the phase bit r.
      */
     class ImprovedStabilizerTableau : public StabilizerTableau {
     private:
         /**
-         * It will be convenient to add an additional (2n + 1)st row for scratch space.
-         * Using this scratch space allows one to override valid qubit index checks.
-         * Use only when performing a measurement.
+         * The number of 64-bit words needed to store the x (or z) bits of one generator.
          */
-        bool using_scratch_space = false;
+        uint qubit_words{};
 
         /**
-         * The algorithm uses a subroutine called rowsum (h, i), which sets generator h equal to i + h.
-         * Its purpose is to keep track, in particular, of the phase bit rh, including all the factors of i
-         * that appear when multiplying Pauli matrices.
-         * @param h The generator to update.
-         * @param i The generator to add to h.
+         * The number of 64-bit words occupied by one generator, i.e. 2 * qubit_words + 1.
          */
-        void rowsum(uint h, uint i);
+        uint row_words{};
+
+        /**
+         * Pauli gates are not applied right away but accumulated in these masks, with one bit per qubit.
+         * A Pauli gate only flips the signs of the generators which anticommute with it, so the pending gates are
+         * equivalent to the Pauli X^pending_x Z^pending_z (up to a global phase), and they are folded into the
+         * r column in one pass by flushPaulis before the tableau is used in any other way.
+         */
+        std::vector<uint64_t> pending_x;
+        std::vector<uint64_t> pending_z;
+
+        /**
+         * Whether any bit of pending_x or pending_z is set.
+         */
+        bool paulis_pending = false;
+
+        /**
+         * The indices of the words of pending_x and pending_z holding a pending gate, collected by
+         * applyPendingPaulis. Kept across flushes, so that flushing does not allocate.
+         * The const saveSnapshot writes it as well, so snapshotting one tableau from several threads is not safe.
+         */
+        mutable std::vector<uint> active_words;
+
+        /**
+         * One gate of a layer, prepared for being applied to one generator after the other.
+         */
+        struct RowOperation {
+            /**
+             * The gate, which is either CNOT, SWAP or CLIFFORD for all single-qubit gates.
+             */
+            Gate gate;
+
+            /**
+             * Word index and bit offset of the first qubit within the x (or z) words of a generator.
+             */
+            uint word1;
+            uint shift1;
+
+            /**
+             * Word index and bit offset of the second qubit of a CNOT or SWAP.
+             */
+            uint word2;
+            uint shift2;
+
+            /**
+             * The single-qubit Clifford of a CLIFFORD.
+             */
+            SingleQubitClifford clifford;
+        };
+
+        /**
+         * Reused storage for the operations of the layer being applied.
+         */
+        std::vector<RowOperation> row_operations;
+
+        /**
+         * Get a pointer to the first word of a generator. The x words are followed by the z words and the r word.
+         * @param i Index of the generator.
+         * @return Pointer to the generator.
+         */
+        uint64_t *row(uint i);
+
+        /**
+         * Find the first generator from first to 2n with xia = 1, reading the x bit of every row directly.
+         * @param word Index of the word holding the x bit of qubit a within the x words.
+         * @param mask Mask selecting the x bit of qubit a within the word.
+         * @param first Index of the first generator to consider.
+         * @return The index of the generator, or 2n + 1 if there is none.
+         */
+        uint first_x_row(uint word, uint64_t mask, uint first);
+
+        /**
+         * Flip the signs of all generators in the given tableau words according to the pending Pauli gates.
+         * @param words Words of a tableau with the layout of this tableau.
+         */
+        void applyPendingPaulis(uint64_t *words) const;
+
+        /**
+         * Apply the pending Pauli gates to the tableau and clear them.
+         */
+        void flushPaulis();
 
         /**
          * Set the value of a bit in the tableau.
@@ -54,11 +130,23 @@ namespace CliffordTableaus {
         uint8_t get(uint index);
 
         /**
-         * Throws an invalid argument exception with the given message if the scratch space is not being used.
+         * Throws an invalid argument exception with the given message.
          * @param message Message to pass to std::invalid_argument.
          */
         void throw_invalid_argument(const std::string &message) const;
 
+    protected:
+        /**
+         * The algorithm uses a subroutine called rowsum (h, i), which sets generator h equal to i + h.
+         * Its purpose is to keep track, in particular, of the phase bit rh, including all the factors of i
+         * that appear when multiplying Pauli matrices.
+         * The exponent of i is accumulated word by word using bit masks and popcounts,
+         * and the x and z bits of generator i are XORed into generator h one word at a time.
+         * @param h The generator to update.
+         * @param i The generator to add to h.
+         */
+        void rowsum(uint h, uint i);
+
     public:
         /**
          * Construct a new ImprovedStabilizerTableau object.
@@ -82,6 +170,40 @@ namespace CliffordTableaus {
         void Phase(uint qubit) override;
 
         uint8_t Measurement(uint qubit) override;
+
+        std::vector<uint8_t> MeasureAll() override;
+
+        OutcomeSpace outcomeSpace() override;
+
+        void PauliX(uint qubit) override;
+
+        void PauliY(uint qubit) override;
+
+        void PauliZ(uint qubit) override;
+
+        void SWAP(uint qubit1, uint qubit2) override;
+
+        void Clifford(uint qubit, const SingleQubitClifford &clifford) override;
+
+        /**
+         * Apply a layer of unitary gates in a single pass over the generators:
+         * every generator is loaded once and all gates of the layer are applied to it before moving on to the next.
+         * This is valid for any sequence of unitary gates since each gate updates every generator independently.
+         * Layers with invalid qubit indices are applied gate by gate to report the invalid gates.
+         * @param layer Instructions of the layer with 0-based qubit operands.
+         */
+        void applyLayer(std::span<const Instruction> layer) override;
+
+        /**
+         * Copy the current state of the tableau into the snapshot, with the pending Pauli gates applied.
+         * Not thread-safe despite being const: it reuses the buffer of applyPendingPaulis.
+         * @param snapshot Snapshot to overwrite.
+         */
+        void saveSnapshot(TableauSnapshot &snapshot) const override;
+
+        void restoreSnapshot(const TableauSnapshot &snapshot) override;
+
+        bool hasRandomOutcome(uint qubit) override;
         /// Superclass overrides end.
 
         /**
@@ -1,7 +1,29 @@
 #include "subroutines.h"
 
+#include <bit>
+#include <mutex>
+#include <random>
+
 
 namespace CliffordTableaus {
+    namespace {
+        /**
+         * Generator of random bits, one per thread.
+         */
+        thread_local Rng generator;
+
+        /**
+         * One step of SplitMix64: advance the counter and return a hash of it.
+         */
+        uint64_t splitmix64(uint64_t &counter) {
+            counter += 0x9e3779b97f4a7c15;
+            uint64_t z = counter;
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+            return z ^ (z >> 31);
+        }
+    }
+
     int g(int x1, int z1, int x2, int z2) {
         auto x1z1 = ((x1 << 1) | z1) & 0b11;
         switch (x1z1) {
@@ -16,7 +38,85 @@ namespace CliffordTableaus {
         }
     }
 
+    int g_packed(const uint64_t *x1, const uint64_t *z1, const uint64_t *x2, const uint64_t *z2, uint words) {
+        int sum_g = 0;
+        for (uint w = 0; w < words; ++w) {
+            // Split the qubits of the first generator into X, Y and Z and evaluate g for each case.
+            uint64_t pauli_x = x1[w] & ~z1[w];
+            uint64_t pauli_y = x1[w] & z1[w];
+            uint64_t pauli_z = ~x1[w] & z1[w];
+            uint64_t plus = (pauli_x & x2[w] & z2[w]) | (pauli_y & ~x2[w] & z2[w]) | (pauli_z & x2[w] & ~z2[w]);
+            uint64_t minus = (pauli_x & ~x2[w] & z2[w]) | (pauli_y & x2[w] & ~z2[w]) | (pauli_z & x2[w] & z2[w]);
+            sum_g += std::popcount(plus) - std::popcount(minus);
+        }
+        return sum_g;
+    }
+
+    void xor_words(uint64_t *destination, const uint64_t *source, uint words) {
+        for (uint w = 0; w < words; ++w) {
+            destination[w] ^= source[w];
+        }
+    }
+
     uint8_t random_bit() {
-        return distribution(generator);
+        return generator.random_bit();
+    }
+
+    uint random_seed() {
+        // std::random_device is not guaranteed to be thread-safe.
+        static std::mutex random_device_mutex;
+        static std::random_device random_device;
+        std::lock_guard<std::mutex> lock(random_device_mutex);
+        // A draw has only 32 bits, two of them fill the 64-bit seed.
+        auto high = static_cast<uint64_t>(random_device());
+        return (high << 32) | random_device();
+    }
+
+    Rng::Rng() {
+        seed(random_seed(), 0);
+    }
+
+    Rng::Rng(uint seed) {
+        this->seed(seed, 0);
+    }
+
+    Rng::Rng(uint seed, uint stream) {
+        this->seed(seed, stream);
+    }
+
+    void Rng::seed(uint64_t seed, uint64_t stream) {
+        // The hash of the stream index moves every stream to an unrelated position of the SplitMix64 sequence,
+        // whose next four outputs form the state. They are all zero with negligible probability only.
+        uint64_t stream_counter = stream;
+        uint64_t counter = seed ^ splitmix64(stream_counter);
+        for (auto &word: state) {
+            word = splitmix64(counter);
+        }
+        bit_pool = 0;
+        bits_left = 0;
+    }
+
+    uint8_t Rng::random_bit() {
+        if (bits_left == 0) {
+            bit_pool = random_word();
+            bits_left = 64;
+        }
+        auto bit = static_cast<uint8_t>(bit_pool & 1);
+        bit_pool >>= 1;
+        --bits_left;
+        return bit;
+    }
+
+    uint64_t Rng::random_word() {
+        // xoshiro256** by Blackman and Vigna.
+        uint64_t result = std::rotl(state[1] * 5, 7) * 9;
+        uint64_t t = state[1] << 17;
+        state[2] ^= state[0];
+        state[3] ^= state[1];
+        state[1] ^= state[2];
+        state[0] ^= state[3];
+        state[2] ^= t;
+        state[3] = std::rotl(state[3], 45);
+        return result;
     }
 }
@@ -1,23 +1,10 @@
 #pragma once
 
-#include <random>
+#include <array>
+#include <cstdint>
 
 namespace CliffordTableaus {
     using uint = std::size_t;
-    /**
-     * Random device for generating random bits.
-     */
-    static std::random_device randomDevice;
-
-    /**
-     * Mersenne Twister engine for generating random bits.
-     */
-    static std::mt19937 generator(randomDevice());
-
-    /**
-     * Uniform distribution for generating random bits.
-     */
-    static std::uniform_int_distribution<> distribution(0, 1);
 
     /**
      * If x1=z1=0 then g_alternate=0;
@@ -29,9 +16,103 @@ namespace CliffordTableaus {
      */
     int g(int x1, int z1, int x2, int z2);
 
+    /**
+     * Sum of g over all qubits of two generators packed into 64-bit words.
+     * For every word the qubits on which g evaluates to +1 and -1 are selected with bit masks
+     * and counted with std::popcount, so the result is identical to summing g qubit by qubit.
+     * @param x1 The x words of the first generator.
+     * @param z1 The z words of the first generator.
+     * @param x2 The x words of the second generator.
+     * @param z2 The z words of the second generator.
+     * @param words Number of words per operand.
+     * @return The sum of g over all qubits, i.e. the exponent of i (not yet reduced modulo 4).
+     */
+    int g_packed(const uint64_t *x1, const uint64_t *z1, const uint64_t *x2, const uint64_t *z2, uint words);
+
+    /**
+     * XOR the source words into the destination words.
+     * @param destination Words to update.
+     * @param source Words to XOR into the destination.
+     * @param words Number of words per operand.
+     */
+    void xor_words(uint64_t *destination, const uint64_t *source, uint words);
+
     /**
      * Generate a random bit, either 0 or 1 with equal probability.
+     * Every thread draws from its own Rng seeded from the random device,
+     * so the function is safe to call concurrently.
      * @return Random bit, either 0 or 1.
      */
     uint8_t random_bit();
+
+    /**
+     * Draw a fresh seed from the random device. Safe to call concurrently.
+     * @return Random seed.
+     */
+    uint random_seed();
+
+    /**
+     * Independent source of random measurement outcomes.
+     * Tableaus draw from the global generator unless they are given an Rng via StabilizerTableau::setRng.
+     * The engine is xoshiro256**, which produces 64 random bits per step. Single bits are handed out
+     * from a pool holding the rest of the last word. The state is derived from a seed and a stream index
+     * with the counter-based SplitMix64, so any number of independent streams can be split off a seed
+     * in constant time, e.g. one stream per shot.
+     */
+    class Rng {
+    private:
+        /**
+         * State of the xoshiro256** engine, never all zero.
+         */
+        std::array<uint64_t, 4> state{};
+
+        /**
+         * Random bits which have not been handed out yet, the next one in the least significant position.
+         */
+        uint64_t bit_pool = 0;
+
+        /**
+         * The number of random bits left in the pool.
+         */
+        uint bits_left = 0;
+
+        /**
+         * Derive the state of the engine from a seed and the index of a stream.
+         * @param seed Seed shared by all streams.
+         * @param stream Index of the stream.
+         */
+        void seed(uint64_t seed, uint64_t stream);
+
+    public:
+        /**
+         * Construct a new Rng seeded from the random device.
+         */
+        Rng();
+
+        /**
+         * Construct a new Rng with a fixed seed, which is stream 0 of the seed.
+         * @param seed Seed of the engine.
+         */
+        explicit Rng(uint seed);
+
+        /**
+         * Construct a new Rng for one of several independent streams derived from the same seed,
+         * e.g. one stream per shot.
+         * @param seed Seed shared by all streams.
+         * @param stream Index of the stream.
+         */
+        Rng(uint seed, uint stream);
+
+        /**
+         * Generate a random bit, either 0 or 1 with equal probability.
+         * @return Random bit, either 0 or 1.
+         */
+        uint8_t random_bit();
+
+        /**
+         * Generate 64 independent random bits at once.
+         * @return Random word with every bit 0 or 1 with equal probability.
+         */
+        uint64_t random_word();
+    };
 }
\ No newline at end of file
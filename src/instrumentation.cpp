@@ -0,0 +1,92 @@
+#include "instrumentation.h"
+
+#include <initializer_list>
+#include <mutex>
+#include <sstream>
+
+namespace CliffordTableaus {
+    namespace {
+        /**
+         * Guards the totals of the threads which have exited.
+         */
+        std::mutex totals_mutex;
+
+        /**
+         * The entries of the threads which have exited.
+         */
+        std::array<StatsEntry, STATS_COUNTER_COUNT> totals{};
+
+        /**
+         * Names of the counters in the JSON report.
+         */
+        constexpr std::array<const char *, STATS_COUNTER_COUNT> counter_names{
+                "identity", "pauli_x", "pauli_y", "pauli_z", "cnot", "hadamard", "phase", "measure", "swap",
+                "clifford", "layers", "random", "determinate", "measure_all", "rowsum", "parse", "compile", "shots"
+        };
+
+        void writeEntry(std::ostringstream &json, StatsCounter counter, const StatsEntry &entry) {
+            json << "\"" << counter_names[counter] << "\": {\"count\": " << entry.count;
+            if (counter >= STATS_PARSE) {
+                json << ", \"seconds\": " << static_cast<double>(entry.nanoseconds) * 1e-9;
+            } else if (Stats::cycles_enabled) {
+                json << ", \"cycles\": " << entry.cycles;
+            }
+            json << "}";
+        }
+
+        void writeGroup(std::ostringstream &json, const char *name,
+                        const std::array<StatsEntry, STATS_COUNTER_COUNT> &entries,
+                        std::initializer_list<StatsCounter> counters) {
+            json << "\"" << name << "\": {";
+            const char *separator = "";
+            for (auto counter: counters) {
+                json << separator;
+                writeEntry(json, counter, entries[counter]);
+                separator = ", ";
+            }
+            json << "}";
+        }
+    }
+
+    ThreadStats::~ThreadStats() {
+        std::lock_guard lock(totals_mutex);
+        for (uint counter = 0; counter < STATS_COUNTER_COUNT; ++counter) {
+            totals[counter].count += entries[counter].count;
+            totals[counter].cycles += entries[counter].cycles;
+            totals[counter].nanoseconds += entries[counter].nanoseconds;
+        }
+    }
+
+    std::array<StatsEntry, STATS_COUNTER_COUNT> Stats::collect() {
+        std::lock_guard lock(totals_mutex);
+        auto collected = totals;
+        for (uint counter = 0; counter < STATS_COUNTER_COUNT; ++counter) {
+            collected[counter].count += thread_stats.entries[counter].count;
+            collected[counter].cycles += thread_stats.entries[counter].cycles;
+            collected[counter].nanoseconds += thread_stats.entries[counter].nanoseconds;
+        }
+        return collected;
+    }
+
+    void Stats::reset() {
+        std::lock_guard lock(totals_mutex);
+        totals = {};
+        thread_stats.entries = {};
+    }
+
+    std::string Stats::toJson() {
+        auto entries = collect();
+        std::ostringstream json;
+        json << "{\"enabled\": " << (enabled ? "true" : "false")
+             << ", \"cycles\": " << (cycles_enabled ? "true" : "false") << ", ";
+        writeGroup(json, "phases", entries, {STATS_PARSE, STATS_COMPILE, STATS_SHOTS});
+        json << ", ";
+        writeGroup(json, "gates", entries, {STATS_IDENTITY, STATS_PAULI_X, STATS_PAULI_Y, STATS_PAULI_Z, STATS_CNOT,
+                                            STATS_HADAMARD, STATS_PHASE, STATS_SWAP, STATS_CLIFFORD, STATS_LAYER});
+        json << ", ";
+        writeGroup(json, "measurements", entries,
+                   {STATS_RANDOM_MEASUREMENT, STATS_DETERMINATE_MEASUREMENT, STATS_MEASURE_ALL, STATS_ROWSUM});
+        json << "}";
+        return json.str();
+    }
+}
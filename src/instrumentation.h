@@ -0,0 +1,244 @@
+#pragma once
+
+#include "circuit_instruction.h"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+#if defined(CLIFFORD_TABLEAUS_CYCLES) && defined(__x86_64__) && defined(__GNUC__)
+#include <x86intrin.h>
+#define CLIFFORD_TABLEAUS_TSC
+#endif
+
+namespace CliffordTableaus {
+    using uint = std::size_t;
+
+    /**
+     * Events recorded by the instrumentation. The first entries are the gates in the order of Gate,
+     * so that a gate is its own counter. The entry of MEASURE is unused, measurements are split by their outcome.
+     */
+    enum StatsCounter : uint8_t {
+        STATS_IDENTITY,
+        STATS_PAULI_X,
+        STATS_PAULI_Y,
+        STATS_PAULI_Z,
+        STATS_CNOT,
+        STATS_HADAMARD,
+        STATS_PHASE,
+        STATS_MEASURE,
+        STATS_SWAP,
+        STATS_CLIFFORD,
+        STATS_LAYER,
+        STATS_RANDOM_MEASUREMENT,
+        STATS_DETERMINATE_MEASUREMENT,
+        STATS_MEASURE_ALL,
+        STATS_ROWSUM,
+        STATS_PARSE,
+        STATS_COMPILE,
+        STATS_SHOTS,
+        STATS_COUNTER_COUNT
+    };
+
+    // Gates are recorded as static_cast<StatsCounter>(gate).
+    static_assert(STATS_IDENTITY == static_cast<StatsCounter>(IDENTITY) &&
+                  STATS_PAULI_X == static_cast<StatsCounter>(PAULI_X) &&
+                  STATS_PAULI_Y == static_cast<StatsCounter>(PAULI_Y) &&
+                  STATS_PAULI_Z == static_cast<StatsCounter>(PAULI_Z) &&
+                  STATS_CNOT == static_cast<StatsCounter>(CNOT) &&
+                  STATS_HADAMARD == static_cast<StatsCounter>(HADAMARD) &&
+                  STATS_PHASE == static_cast<StatsCounter>(PHASE) &&
+                  STATS_MEASURE == static_cast<StatsCounter>(MEASURE) &&
+                  STATS_SWAP == static_cast<StatsCounter>(SWAP) &&
+                  STATS_CLIFFORD == static_cast<StatsCounter>(CLIFFORD),
+                  "The gate counters must be in the order of Gate.");
+
+    /**
+     * What the instrumentation recorded for one counter.
+     */
+    struct StatsEntry {
+        /**
+         * The number of events.
+         */
+        uint64_t count = 0;
+
+        /**
+         * TSC cycles spent in the events, only recorded if built with CLIFFORD_TABLEAUS_CYCLES.
+         */
+        uint64_t cycles = 0;
+
+        /**
+         * Wall-clock time spent in the events, only recorded for the coarse phases parse, compile and shots.
+         */
+        uint64_t nanoseconds = 0;
+    };
+
+    /**
+     * The entries of the counters recorded by one thread. Merged into the totals when the thread exits.
+     */
+    struct ThreadStats {
+        std::array<StatsEntry, STATS_COUNTER_COUNT> entries{};
+
+        ~ThreadStats();
+    };
+
+    /**
+     * Instrumentation of the hot paths, enabled at compile time with CLIFFORD_TABLEAUS_STATS.
+     * The improved tableaus (ImprovedStabilizerTableau and FixedStabilizerTableau) count their gates by type,
+     * applied layers, random and determinate measurements and rowsums, the circuit readers record the time spent
+     * parsing and compiling circuits, and the ShotRunner the time spent executing shots.
+     * With CLIFFORD_TABLEAUS_CYCLES the hot-path events additionally accumulate TSC cycles. Rowsums run inside
+     * measurements, so their cycles are part of those of the measurements as well.
+     * Every thread counts into its own entries, so the counters cost one increment of thread-local memory.
+     * Without CLIFFORD_TABLEAUS_STATS all TABLEAU_STATS macros expand to nothing.
+     */
+    class Stats {
+    public:
+        /**
+         * Whether the instrumentation is compiled in.
+         */
+#ifdef CLIFFORD_TABLEAUS_STATS
+        static constexpr bool enabled = true;
+#else
+        static constexpr bool enabled = false;
+#endif
+
+        /**
+         * Whether the hot-path events accumulate TSC cycles.
+         */
+#if defined(CLIFFORD_TABLEAUS_STATS) && defined(CLIFFORD_TABLEAUS_TSC)
+        static constexpr bool cycles_enabled = true;
+#else
+        static constexpr bool cycles_enabled = false;
+#endif
+
+        /**
+         * Record events.
+         * @param counter The counter of the events.
+         * @param count The number of events.
+         */
+        static void add(StatsCounter counter, uint64_t count = 1) {
+            thread_stats.entries[counter].count += count;
+        }
+
+        /**
+         * Read the time stamp counter.
+         * @return The current TSC value, or 0 if cycles are not accounted.
+         */
+        static uint64_t cycles() {
+#ifdef CLIFFORD_TABLEAUS_TSC
+            return __rdtsc();
+#else
+            return 0;
+#endif
+        }
+
+        /**
+         * Sum the entries of all threads which have exited and of the calling thread.
+         * Call it after the worker threads are joined, e.g. once ShotRunner has returned.
+         * @return The total of every counter.
+         */
+        static std::array<StatsEntry, STATS_COUNTER_COUNT> collect();
+
+        /**
+         * Reset the totals and the entries of the calling thread.
+         */
+        static void reset();
+
+        /**
+         * Format the collected totals as a JSON object, grouping the gates, the measurements and the phases.
+         * @return The JSON object.
+         */
+        static std::string toJson();
+
+    private:
+        friend class StatsTimer;
+
+        friend class PhaseTimer;
+
+        /**
+         * The entries of the calling thread.
+         */
+        static inline thread_local ThreadStats thread_stats;
+    };
+
+    /**
+     * Records one event of a counter for its scope, including its cycles if they are accounted.
+     * The counter may be changed before the end of the scope, e.g. once a measurement turns out to be random.
+     */
+    class StatsTimer {
+    public:
+        explicit StatsTimer(StatsCounter p_counter) : counter(p_counter), start(Stats::cycles()) {}
+
+        ~StatsTimer() {
+            auto &entry = Stats::thread_stats.entries[counter];
+            ++entry.count;
+            if constexpr (Stats::cycles_enabled) {
+                entry.cycles += Stats::cycles() - start;
+            }
+        }
+
+        StatsTimer(const StatsTimer &) = delete;
+
+        StatsTimer &operator=(const StatsTimer &) = delete;
+
+        /**
+         * The counter to which the event is recorded.
+         */
+        StatsCounter counter;
+
+    private:
+        uint64_t start;
+    };
+
+    /**
+     * Records the wall-clock time of a coarse phase for its scope. Too slow for the hot paths.
+     */
+    class PhaseTimer {
+    public:
+        explicit PhaseTimer(StatsCounter p_counter, uint64_t p_count = 1)
+                : counter(p_counter), count(p_count), start(std::chrono::steady_clock::now()) {}
+
+        ~PhaseTimer() {
+            auto &entry = Stats::thread_stats.entries[counter];
+            entry.count += count;
+            entry.nanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - start
+            ).count();
+        }
+
+        PhaseTimer(const PhaseTimer &) = delete;
+
+        PhaseTimer &operator=(const PhaseTimer &) = delete;
+
+    private:
+        StatsCounter counter;
+        uint64_t count;
+        std::chrono::steady_clock::time_point start;
+    };
+}
+
+#ifdef CLIFFORD_TABLEAUS_STATS
+/**
+ * Record count events of a counter.
+ */
+#define TABLEAU_STATS_ADD(counter, count) ::CliffordTableaus::Stats::add(counter, count)
+/**
+ * Record one event of a counter for the rest of the scope, see StatsTimer.
+ */
+#define TABLEAU_STATS_TIMER(name, counter) ::CliffordTableaus::StatsTimer name(counter)
+/**
+ * Change the counter of a timer declared with TABLEAU_STATS_TIMER.
+ */
+#define TABLEAU_STATS_RECLASSIFY(name, p_counter) (name.counter = (p_counter))
+/**
+ * Record the wall-clock time of the rest of the scope as count events of a phase, see PhaseTimer.
+ */
+#define TABLEAU_STATS_PHASE(name, counter, count) ::CliffordTableaus::PhaseTimer name(counter, count)
+#else
+#define TABLEAU_STATS_ADD(counter, count) ((void) 0)
+#define TABLEAU_STATS_TIMER(name, counter) ((void) 0)
+#define TABLEAU_STATS_RECLASSIFY(name, counter) ((void) 0)
+#define TABLEAU_STATS_PHASE(name, counter, count) ((void) 0)
+#endif
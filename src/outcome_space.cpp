@@ -0,0 +1,155 @@
+#include "outcome_space.h"
+#include "stim_a_fast_stabilizer_circuit_simulator/simd_kernels.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+
+namespace CliffordTableaus {
+    namespace {
+        uint64_t bit(const uint64_t *vector, uint j) {
+            return (vector[j / 64] >> (j % 64)) & 1;
+        }
+    }
+
+    OutcomeSpace::OutcomeSpace(uint p_n, std::vector<uint64_t> p_offset, std::vector<uint64_t> p_basis)
+            : n(p_n), qubit_words((p_n + 63) / 64), offset(std::move(p_offset)), basis(std::move(p_basis)),
+              measured(qubit_words, ~uint64_t{0}) {
+        if (offset.size() != qubit_words || basis.size() % std::max<uint>(qubit_words, 1) != 0) {
+            throw std::invalid_argument("Vectors of the outcome space do not match the number of qubits.");
+        }
+        if (n % 64 != 0) {
+            measured.back() = (uint64_t{1} << (n % 64)) - 1;
+        }
+        reduce();
+    }
+
+    void OutcomeSpace::reduce() {
+        auto vector = [&](uint k) {
+            return basis.data() + k * qubit_words;
+        };
+        auto &kernels = simd_kernels();
+        auto count = qubit_words == 0 ? 0 : basis.size() / qubit_words;
+        pivots.clear();
+        for (uint j = 0; j < n && pivots.size() < count; ++j) {
+            auto rank = pivots.size();
+            auto pivot = rank;
+            while (pivot < count && bit(vector(pivot), j) == 0) {
+                ++pivot;
+            }
+            if (pivot == count) {
+                continue;
+            }
+            std::swap_ranges(vector(pivot), vector(pivot) + qubit_words, vector(rank));
+            for (uint h = 0; h < count; ++h) {
+                if (h != rank && bit(vector(h), j) == 1) {
+                    kernels.xor_words(vector(h), vector(rank), qubit_words);
+                }
+            }
+            pivots.push_back(j);
+        }
+        basis.resize(pivots.size() * qubit_words);
+
+        // The pivot bits of the offset can be cleared by adding basis vectors, which does not change the subspace.
+        for (uint k = 0; k < pivots.size(); ++k) {
+            if (bit(offset.data(), pivots[k]) == 1) {
+                kernels.xor_words(offset.data(), vector(k), qubit_words);
+            }
+        }
+    }
+
+    void OutcomeSpace::restrict(const std::vector<uint32_t> &p_measured) {
+        std::fill(measured.begin(), measured.end(), 0);
+        for (auto q: p_measured) {
+            if (q < n) {
+                measured[q / 64] |= uint64_t{1} << (q % 64);
+            }
+        }
+        // The vectors of the other qubits become 0 or equal to others, which reduce drops.
+        for (uint w = 0; w < offset.size(); ++w) {
+            offset[w] &= measured[w];
+        }
+        for (uint w = 0; w < basis.size(); ++w) {
+            basis[w] &= measured[w % qubit_words];
+        }
+        reduce();
+    }
+
+    std::string OutcomeSpace::toString(const uint64_t *vector) const {
+        std::string outcome(n, 'x');
+        for (uint j = 0; j < n; ++j) {
+            if (bit(measured.data(), j) == 1) {
+                outcome[j] = static_cast<char>('0' + bit(vector, j));
+            }
+        }
+        return outcome;
+    }
+
+    uint OutcomeSpace::qubits() const {
+        return n;
+    }
+
+    uint OutcomeSpace::dimension() const {
+        return pivots.size();
+    }
+
+    double OutcomeSpace::probability() const {
+        return std::ldexp(1.0, -static_cast<int>(dimension()));
+    }
+
+    std::string OutcomeSpace::offsetString() const {
+        return toString(offset.data());
+    }
+
+    std::vector<std::string> OutcomeSpace::basisStrings() const {
+        std::vector<std::string> strings;
+        strings.reserve(dimension());
+        for (uint k = 0; k < dimension(); ++k) {
+            strings.push_back(toString(basis.data() + k * qubit_words));
+        }
+        return strings;
+    }
+
+    bool OutcomeSpace::contains(const std::string &outcome) const {
+        if (outcome.size() != n) {
+            return false;
+        }
+        std::vector<uint64_t> difference(offset);
+        for (uint j = 0; j < n; ++j) {
+            auto is_measured = bit(measured.data(), j) == 1;
+            if (outcome[j] == 'x' ? is_measured : !is_measured || (outcome[j] != '0' && outcome[j] != '1')) {
+                return false;
+            }
+            if (outcome[j] == '1') {
+                difference[j / 64] ^= uint64_t{1} << (j % 64);
+            }
+        }
+        // The outcome lies in the subspace iff eliminating the pivots of the difference leaves nothing.
+        for (uint k = 0; k < dimension(); ++k) {
+            if (bit(difference.data(), pivots[k]) == 1) {
+                simd_kernels().xor_words(difference.data(), basis.data() + k * qubit_words, qubit_words);
+            }
+        }
+        return std::all_of(difference.begin(), difference.end(), [](uint64_t word) { return word == 0; });
+    }
+
+    std::vector<std::string> OutcomeSpace::outcomes() const {
+        if (dimension() > max_enumerated_dimension) {
+            throw std::length_error("The outcome space of dimension " + std::to_string(dimension()) +
+                                    " is too large to enumerate.");
+        }
+        // Visit the outcomes in Gray code order, so that each one differs from the last by a single basis vector.
+        std::vector<std::string> strings;
+        strings.reserve(uint{1} << dimension());
+        std::vector<uint64_t> current(offset);
+        strings.push_back(toString(current.data()));
+        for (uint index = 1; index < (uint{1} << dimension()); ++index) {
+            auto k = static_cast<uint>(std::countr_zero(index));
+            simd_kernels().xor_words(current.data(), basis.data() + k * qubit_words, qubit_words);
+            strings.push_back(toString(current.data()));
+        }
+        return strings;
+    }
+}
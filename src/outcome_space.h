@@ -0,0 +1,135 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace CliffordTableaus {
+    using uint = std::size_t;
+
+    /**
+     * The exact distribution of the outcomes of measuring a stabilizer state in the standard basis.
+     * The outcomes are uniformly distributed over an affine subspace of GF(2)^n: every outcome is the offset
+     * plus a sum of basis vectors, and each of the 2^dimension outcomes occurs with probability 2^-dimension.
+     * Qubits which are not measured are excluded from the subspace and reported as 'x'.
+     * The vectors are packed into words, the 0-based qubit j at bit j % 64 of word j / 64.
+     * The basis is kept in reduced row echelon form and the offset reduced by it, so two equal distributions
+     * have the same offset and basis regardless of how they were computed.
+     */
+    class OutcomeSpace {
+    private:
+        /**
+         * The number of qubits.
+         */
+        uint n{};
+
+        /**
+         * The number of words of a vector.
+         */
+        uint qubit_words{};
+
+        /**
+         * The outcome with all pivot qubits 0.
+         */
+        std::vector<uint64_t> offset;
+
+        /**
+         * The basis vectors, one after the other.
+         */
+        std::vector<uint64_t> basis;
+
+        /**
+         * The pivot qubit of every basis vector, 0-based and in increasing order.
+         * It is the lowest qubit of the vector and not contained in any other basis vector.
+         */
+        std::vector<uint> pivots;
+
+        /**
+         * The measured qubits, as a vector.
+         */
+        std::vector<uint64_t> measured;
+
+        /**
+         * Bring the basis into reduced row echelon form by Gaussian elimination, dropping dependent vectors,
+         * and reduce the offset by it.
+         */
+        void reduce();
+
+        /**
+         * Format a vector as a measurement string, using 'x' for the qubits which are not measured.
+         * @param vector Words of the vector.
+         * @return The measurement string, the 0-based qubit j at index j.
+         */
+        [[nodiscard]] std::string toString(const uint64_t *vector) const;
+
+    public:
+        /**
+         * Dimension above which outcomes refuses to enumerate the subspace.
+         */
+        static constexpr uint max_enumerated_dimension = 24;
+
+        /**
+         * Default Constructor of the distribution of no qubits.
+         */
+        OutcomeSpace() = default;
+
+        /**
+         * Construct the distribution of measuring all qubits from an offset and a spanning set of the subspace.
+         * @param p_n The number of qubits.
+         * @param p_offset Any outcome of the distribution, given by (n + 63) / 64 words.
+         * @param p_basis Vectors spanning the subspace, each given by (n + 63) / 64 words. May be dependent.
+         */
+        OutcomeSpace(uint p_n, std::vector<uint64_t> p_offset, std::vector<uint64_t> p_basis);
+
+        /**
+         * Restrict the distribution to the given qubits, i.e. marginalize over all other qubits.
+         * The marginal of a uniform distribution over an affine subspace is again one.
+         * @param p_measured The 0-based indices of the qubits to keep.
+         */
+        void restrict(const std::vector<uint32_t> &p_measured);
+
+        /**
+         * Get the number of qubits.
+         * @return The number of qubits.
+         */
+        [[nodiscard]] uint qubits() const;
+
+        /**
+         * Get the dimension of the subspace, i.e. the number of independent random outcomes.
+         * @return The dimension.
+         */
+        [[nodiscard]] uint dimension() const;
+
+        /**
+         * Get the probability of every outcome of the distribution.
+         * @return 2^-dimension.
+         */
+        [[nodiscard]] double probability() const;
+
+        /**
+         * Get the offset of the subspace.
+         * @return The offset as a measurement string.
+         */
+        [[nodiscard]] std::string offsetString() const;
+
+        /**
+         * Get the basis of the subspace.
+         * @return The basis vectors as measurement strings.
+         */
+        [[nodiscard]] std::vector<std::string> basisStrings() const;
+
+        /**
+         * Check whether a measurement string is an outcome of the distribution.
+         * @param outcome Measurement string using '0', '1' and 'x'.
+         * @return True if the outcome has a probability greater than 0.
+         */
+        [[nodiscard]] bool contains(const std::string &outcome) const;
+
+        /**
+         * Enumerate all outcomes of the distribution.
+         * Throws a length error if the dimension exceeds max_enumerated_dimension.
+         * @return The 2^dimension measurement strings, in no particular order.
+         */
+        [[nodiscard]] std::vector<std::string> outcomes() const;
+    };
+}
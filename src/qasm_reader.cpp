@@ -0,0 +1,198 @@
+#include "qasm_reader.h"
+
+#include <array>
+#include <charconv>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace CliffordTableaus {
+    namespace {
+        /**
+         * Release the consumed pages in steps of this many bytes, which keeps the number of system calls negligible.
+         */
+        constexpr std::size_t release_granularity = std::size_t{64} << 20;
+
+        /**
+         * Consume the prefix from the text if it is present.
+         * @return Whether the text started with the prefix.
+         */
+        bool consume(std::string_view &text, std::string_view prefix) {
+            if (!text.starts_with(prefix)) {
+                return false;
+            }
+            text.remove_prefix(prefix.size());
+            return true;
+        }
+
+        /**
+         * Consume a qubit operand 'q[i]' from the text.
+         * @return Whether the text started with a valid operand.
+         */
+        bool consumeQubit(std::string_view &text, uint32_t &qubit) {
+            if (!consume(text, "q[")) {
+                return false;
+            }
+            auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), qubit);
+            if (error != std::errc() || end == text.data()) {
+                return false;
+            }
+            text.remove_prefix(end - text.data());
+            return consume(text, "]");
+        }
+    }
+
+    QasmReader::QasmReader(const std::filesystem::path &circuit_path) {
+        file_descriptor = ::open(circuit_path.c_str(), O_RDONLY);
+        if (file_descriptor < 0) {
+            throw std::runtime_error("Unable to open file for reading: " + circuit_path.string());
+        }
+        struct stat file_status{};
+        if (::fstat(file_descriptor, &file_status) != 0) {
+            ::close(file_descriptor);
+            throw std::runtime_error("Unable to read file size: " + circuit_path.string());
+        }
+        size = static_cast<std::size_t>(file_status.st_size);
+        // Mapping an empty file fails, it simply has no lines.
+        if (size > 0) {
+            auto mapping = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file_descriptor, 0);
+            if (mapping == MAP_FAILED) {
+                ::close(file_descriptor);
+                throw std::runtime_error("Unable to map file: " + circuit_path.string());
+            }
+            // The file is read front to back exactly once.
+            ::madvise(mapping, size, MADV_SEQUENTIAL);
+            data = static_cast<const char *>(mapping);
+        }
+    }
+
+    QasmReader::~QasmReader() {
+        if (data != nullptr) {
+            ::munmap(const_cast<char *>(data), size);
+        }
+        if (file_descriptor >= 0) {
+            ::close(file_descriptor);
+        }
+    }
+
+    bool QasmReader::nextLine(std::string_view &line) {
+        if (position >= size) {
+            return false;
+        }
+        std::string_view remaining(data + position, size - position);
+        auto line_end = remaining.find('\n');
+        if (line_end == std::string_view::npos) {
+            line = remaining;
+            position = size;
+        } else {
+            line = remaining.substr(0, line_end);
+            position += line_end + 1;
+        }
+        return true;
+    }
+
+    void QasmReader::releaseConsumedPages() {
+        static const auto page_size = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+        auto consumed = position / page_size * page_size;
+        if (consumed >= released + release_granularity) {
+            ::madvise(const_cast<char *>(data) + released, consumed - released, MADV_DONTNEED);
+            released = consumed;
+        }
+    }
+
+    bool QasmReader::readHeader(uint &n_qubits) {
+        std::string_view line;
+        if (!nextLine(line) || line != "OPENQASM 3;") {
+            std::cerr << "Invalid QASM format: missing 'OPENQASM 3;' on the first line." << std::endl;
+            return false;
+        }
+
+        // Read the second line (qreg q[n];) and parse the number of qubits
+        if (!nextLine(line)) {
+            std::cerr << "Invalid QASM format: missing 'qreg q[n];' on the second line." << std::endl;
+            return false;
+        }
+
+        if (line == "include \"stdgates.inc\";") {
+            if (!nextLine(line)) {
+                std::cerr << "Invalid QASM format: missing 'qreg q[n];' after include statement." << std::endl;
+                return false;
+            }
+        }
+
+        if (!parseQregLine(line, n_qubits)) {
+            std::cerr << "Invalid QASM format: 'qreg q[n];' expected on the second line." << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    uint QasmReader::readChunk(std::vector<Instruction> &chunk, uint max_instructions) {
+        chunk.clear();
+        std::string_view line;
+        Instruction instruction{};
+        while (chunk.size() < max_instructions && nextLine(line)) {
+            if (line.empty()) {
+                continue;
+            }
+            if (parseGateLine(line, instruction)) {
+                chunk.push_back(instruction);
+            } else {
+                std::cerr << "Warning: " << line << " is not a valid QASM3 line." << std::endl;
+            }
+        }
+        if (data != nullptr) {
+            releaseConsumedPages();
+        }
+        return chunk.size();
+    }
+
+    bool QasmReader::parseGateLine(std::string_view line, Instruction &instruction) {
+        // Gates are dispatched on their name, which is terminated by the space before the first operand.
+        static constexpr std::array<std::pair<std::string_view, Gate>, 9> gate_names{{
+                {"id ", IDENTITY},
+                {"cx ", CNOT},
+                {"h ", HADAMARD},
+                {"s ", PHASE},
+                {"measure ", MEASURE},
+                {"x ", PAULI_X},
+                {"y ", PAULI_Y},
+                {"z ", PAULI_Z},
+                {"swap ", SWAP}
+        }};
+        for (const auto &[name, gate]: gate_names) {
+            if (!consume(line, name)) {
+                continue;
+            }
+            instruction = {gate, 0, 0};
+            if (!consumeQubit(line, instruction.qubit1)) {
+                return false;
+            }
+            if (gate == CNOT || gate == SWAP) {
+                if (!consume(line, ",") || !consumeQubit(line, instruction.qubit2)) {
+                    return false;
+                }
+            }
+            return line == ";";
+        }
+        return false;
+    }
+
+    bool QasmReader::parseQregLine(std::string_view line, uint &n_qubits) {
+        if (!consume(line, "qreg q[")) {
+            return false;
+        }
+        auto [end, error] = std::from_chars(line.data(), line.data() + line.size(), n_qubits);
+        if (error != std::errc() || end == line.data()) {
+            return false;
+        }
+        line.remove_prefix(end - line.data());
+        return line == "];";
+    }
+}
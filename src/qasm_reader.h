@@ -0,0 +1,113 @@
+#pragma once
+
+#include "circuit_instruction.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <string_view>
+#include <vector>
+
+namespace CliffordTableaus {
+    using uint = std::size_t;
+
+    /**
+     * Reader for stabilizer circuits in QASM3 format, built for circuits far larger than the available memory.
+     * The file is memory-mapped and scanned in place, every line is tokenized as a std::string_view into the mapping,
+     * so no line is ever copied or allocated.
+     * Instructions are handed out in chunks of bounded size, and the pages of the file which have been consumed
+     * are released again, so the memory use does not depend on the size of the file.
+     */
+    class QasmReader {
+    private:
+        /**
+         * File descriptor of the circuit file.
+         */
+        int file_descriptor = -1;
+
+        /**
+         * Start of the mapped file.
+         */
+        const char *data = nullptr;
+
+        /**
+         * Size of the file in bytes.
+         */
+        std::size_t size = 0;
+
+        /**
+         * Offset of the next unread byte.
+         */
+        std::size_t position = 0;
+
+        /**
+         * Offset up to which the mapped pages have been released.
+         */
+        std::size_t released = 0;
+
+        /**
+         * Read the next line without its line break.
+         * @param line Set to the line, pointing into the mapped file.
+         * @return Whether a line was read, false at the end of the file.
+         */
+        bool nextLine(std::string_view &line);
+
+        /**
+         * Release the pages of the mapping which have been read completely.
+         */
+        void releaseConsumedPages();
+
+    public:
+        /**
+         * The default number of instructions per chunk.
+         */
+        static constexpr uint default_chunk_size = 4096;
+
+        /**
+         * Open and map the circuit file.
+         * Throws a runtime error if the file cannot be opened or mapped.
+         * @param circuit_path Path to the file containing the circuit in QASM3 format.
+         */
+        explicit QasmReader(const std::filesystem::path &circuit_path);
+
+        QasmReader(const QasmReader &) = delete;
+
+        QasmReader &operator=(const QasmReader &) = delete;
+
+        /**
+         * Unmap and close the circuit file.
+         */
+        ~QasmReader();
+
+        /**
+         * Read the header of the circuit: 'OPENQASM 3;', optionally 'include "stdgates.inc";', and 'qreg q[n];'.
+         * Must be called once before the first chunk is read.
+         * @param n_qubits Number of qubits declared by the circuit.
+         * @return Whether the header is valid.
+         */
+        bool readHeader(uint &n_qubits);
+
+        /**
+         * Read the next instructions of the circuit. Invalid lines are reported and skipped.
+         * @param chunk Cleared and filled with the next instructions in order of execution.
+         * @param max_instructions Maximum number of instructions to read.
+         * @return The number of instructions read, 0 once the end of the file is reached.
+         */
+        uint readChunk(std::vector<Instruction> &chunk, uint max_instructions = default_chunk_size);
+
+        /**
+         * Parse a line in QASM3 syntax into an instruction.
+         * @param line Line in QASM3 syntax which describes the operation to perform.
+         * @param instruction Instruction to write the parsed operation to.
+         * @return Whether the line is a valid operation.
+         */
+        static bool parseGateLine(std::string_view line, Instruction &instruction);
+
+        /**
+         * Parse the declaration of the qubit register 'qreg q[n];'.
+         * @param line Line in QASM3 syntax.
+         * @param n_qubits Set to the number of qubits n.
+         * @return Whether the line is a valid declaration.
+         */
+        static bool parseQregLine(std::string_view line, uint &n_qubits);
+    };
+}
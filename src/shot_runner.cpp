@@ -0,0 +1,163 @@
+#include "shot_runner.h"
+#include "instrumentation.h"
+#include "improved_simulation_of_stabilizer_circuits/fixed_stabilizer_tableau.h"
+#include "improved_simulation_of_stabilizer_circuits/improved_stabilizer_tableau.h"
+#include "sparse_stabilizer_tableau/sparse_stabilizer_tableau.h"
+#include "stim_a_fast_stabilizer_circuit_simulator/frame_simulator.h"
+#include "stim_a_fast_stabilizer_circuit_simulator/packed_stabilizer_tableau.h"
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <thread>
+#include <typeinfo>
+#include <vector>
+
+namespace CliffordTableaus {
+    namespace {
+        /**
+         * Call work with the tableau cast to its dynamic type if that is one of the tableaus of this library,
+         * so that the work is instantiated for the concrete type and runs without virtual calls.
+         * Other tableaus, including subclasses of the library's tableaus, are passed on as StabilizerTableau.
+         */
+        template<class Work>
+        void withConcreteTableau(StabilizerTableau &tableau, Work work) {
+            const auto &type = typeid(tableau);
+            if (type == typeid(ImprovedStabilizerTableau)) {
+                work(static_cast<ImprovedStabilizerTableau &>(tableau));
+            } else if (type == typeid(FixedStabilizerTableau<64>)) {
+                work(static_cast<FixedStabilizerTableau<64> &>(tableau));
+            } else if (type == typeid(FixedStabilizerTableau<128>)) {
+                work(static_cast<FixedStabilizerTableau<128> &>(tableau));
+            } else if (type == typeid(FixedStabilizerTableau<256>)) {
+                work(static_cast<FixedStabilizerTableau<256> &>(tableau));
+            } else if (type == typeid(PackedStabilizerTableau)) {
+                work(static_cast<PackedStabilizerTableau &>(tableau));
+            } else if (type == typeid(SparseStabilizerTableau)) {
+                work(static_cast<SparseStabilizerTableau &>(tableau));
+            } else {
+                work(tableau);
+            }
+        }
+    }
+
+    ShotRunner::Histogram ShotRunner::runShots(
+            const CompiledCircuit &circuit,
+            const TableauFactory &tableau_factory,
+            uint num_shots,
+            uint num_threads,
+            const ProgressCallback &progress,
+            std::optional<uint> seed
+    ) {
+        // The deterministic prefix is identical for every shot, so it is simulated once
+        // and every shot restores the state after it instead of replaying it.
+        auto prefix = circuit.simulatePrefix(*tableau_factory());
+        auto shot_seed = seed.value_or(random_seed());
+
+        return runWorkers(num_shots, num_threads, progress, [&](uint first_shot, uint last_shot,
+                                                                  Histogram &histogram,
+                                                                  std::atomic<uint> &completed_shots) {
+            auto tableau = tableau_factory();
+            withConcreteTableau(*tableau, [&](auto &concrete_tableau) {
+                for (uint shot = first_shot; shot < last_shot; ++shot) {
+                    Rng rng(shot_seed, shot);
+                    ++histogram[circuit.runFromPrefix(prefix, concrete_tableau, rng)];
+                    completed_shots.fetch_add(1, std::memory_order_relaxed);
+                }
+            });
+        });
+    }
+
+    ShotRunner::Histogram ShotRunner::sampleFrames(
+            const CompiledCircuit &circuit,
+            const TableauFactory &tableau_factory,
+            uint num_shots,
+            uint num_threads,
+            const ProgressCallback &progress,
+            std::optional<uint> seed
+    ) {
+        // One shot simulated with a tableau serves as the reference for all frames.
+        // It uses the stream after the last shot, so that it is independent of all batches.
+        auto shot_seed = seed.value_or(random_seed());
+        Rng reference_rng(shot_seed, num_shots);
+        auto reference_sample = circuit.run(*tableau_factory(), reference_rng);
+
+        return runWorkers(num_shots, num_threads, progress, [&](uint first_shot, uint last_shot,
+                                                                  Histogram &histogram,
+                                                                  std::atomic<uint> &completed_shots) {
+            FrameSimulator simulator(circuit, reference_sample);
+            // The batches are aligned to multiples of the batch size across all shots, and a worker samples the
+            // batches starting in its range of shots. Every batch thus uses the same shots and the same stream
+            // regardless of the number of workers.
+            auto batch_size = simulator.batchSize();
+            for (uint shot = (first_shot + batch_size - 1) / batch_size * batch_size;
+                 shot < last_shot; shot += batch_size) {
+                auto batch = std::min(batch_size, num_shots - shot);
+                Rng rng(shot_seed, shot);
+                simulator.sampleBatch(batch, rng, histogram);
+                completed_shots.fetch_add(batch, std::memory_order_relaxed);
+            }
+        });
+    }
+
+    ShotRunner::Histogram ShotRunner::runWorkers(
+            uint num_shots,
+            uint num_threads,
+            const ProgressCallback &progress,
+            const Worker &work
+    ) {
+        if (num_threads == 0) {
+            num_threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        num_threads = std::max<uint>(1, std::min(num_threads, num_shots));
+        TABLEAU_STATS_PHASE(timer, STATS_SHOTS, num_shots);
+
+        std::vector<Histogram> histograms(num_threads);
+        std::vector<std::exception_ptr> errors(num_threads);
+        std::atomic<uint> completed_shots{0};
+        std::atomic<uint> finished_workers{0};
+
+        auto worker = [&](uint worker_index) {
+            try {
+                uint first_shot = num_shots * worker_index / num_threads;
+                uint last_shot = num_shots * (worker_index + 1) / num_threads;
+                work(first_shot, last_shot, histograms[worker_index], completed_shots);
+            } catch (...) {
+                errors[worker_index] = std::current_exception();
+            }
+            finished_workers.fetch_add(1, std::memory_order_release);
+        };
+
+        std::vector<std::thread> threads;
+        threads.reserve(num_threads);
+        for (uint worker_index = 0; worker_index < num_threads; ++worker_index) {
+            threads.emplace_back(worker, worker_index);
+        }
+        if (progress) {
+            while (finished_workers.load(std::memory_order_acquire) < num_threads) {
+                progress(completed_shots.load(std::memory_order_relaxed), num_shots);
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            }
+        }
+        for (auto &thread: threads) {
+            thread.join();
+        }
+        for (auto &error: errors) {
+            if (error) {
+                std::rethrow_exception(error);
+            }
+        }
+        if (progress) {
+            progress(num_shots, num_shots);
+        }
+
+        // Merge the per-worker histograms.
+        Histogram merged = std::move(histograms[0]);
+        for (uint worker_index = 1; worker_index < num_threads; ++worker_index) {
+            for (const auto &[measurement, count]: histograms[worker_index]) {
+                merged[measurement] += count;
+            }
+        }
+        return merged;
+    }
+}
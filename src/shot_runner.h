@@ -0,0 +1,105 @@
+#pragma once
+
+#include "compiled_circuit.h"
+#include "stabilizer_tableau.h"
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+namespace CliffordTableaus {
+    using uint = std::size_t;
+
+    /**
+     * Executes many shots of a compiled circuit, optionally spread across a pool of worker threads.
+     * Every worker owns its own tableau and records its outcomes in a private histogram,
+     * which are merged once all workers are done.
+     * Every shot draws its outcomes from its own Rng stream, split off a common seed by the index of the shot
+     * (for frame sampling, by the index of the first shot of the batch). Given a seed, the histogram is therefore
+     * reproducible and independent of the number of threads.
+     * The prefix of the circuit before its first random measurement is simulated only once,
+     * every shot starts from a snapshot of the tableau after the prefix.
+     * Shots on the tableaus of this library are executed by the instantiation of CompiledCircuit for their type,
+     * only the interactive mode and other tableaus go through the virtual interface of StabilizerTableau.
+     */
+    class ShotRunner {
+    public:
+        /**
+         * Creates a fresh tableau for a worker.
+         */
+        using TableauFactory = std::function<std::unique_ptr<StabilizerTableau>()>;
+
+        /**
+         * Histogram of measurement strings.
+         */
+        using Histogram = std::unordered_map<std::string, unsigned int>;
+
+        /**
+         * Reports the number of completed shots out of the total number of shots.
+         */
+        using ProgressCallback = std::function<void(uint completed, uint total)>;
+
+        /**
+         * Execute the shots of the circuit.
+         * @param circuit The circuit to execute.
+         * @param tableau_factory Creates the tableau of each worker.
+         * @param num_shots Number of shots to execute.
+         * @param num_threads Number of worker threads. 0 selects the number of hardware threads.
+         * @param progress Optional callback, invoked periodically from the calling thread.
+         * @param seed Seed of the Rng streams of the shots. If omitted, a seed is drawn from the random device.
+         * @return Histogram of the measurement strings of all shots.
+         */
+        static Histogram runShots(
+                const CompiledCircuit &circuit,
+                const TableauFactory &tableau_factory,
+                uint num_shots,
+                uint num_threads = 1,
+                const ProgressCallback &progress = nullptr,
+                std::optional<uint> seed = std::nullopt
+        );
+
+        /**
+         * Sample the shots of a circuit with Pauli frames, see FrameSimulator.
+         * One reference shot is executed with a tableau, all shots are then sampled in bit-packed batches.
+         * Valid because the circuits contain no classical feedback.
+         * @param circuit The circuit to sample.
+         * @param tableau_factory Creates the tableau executing the reference shot.
+         * @param num_shots Number of shots to sample.
+         * @param num_threads Number of worker threads. 0 selects the number of hardware threads.
+         * @param progress Optional callback, invoked periodically from the calling thread.
+         * @param seed Seed of the Rng streams of the batches. If omitted, a seed is drawn from the random device.
+         * @return Histogram of the measurement strings of all shots.
+         */
+        static Histogram sampleFrames(
+                const CompiledCircuit &circuit,
+                const TableauFactory &tableau_factory,
+                uint num_shots,
+                uint num_threads = 1,
+                const ProgressCallback &progress = nullptr,
+                std::optional<uint> seed = std::nullopt
+        );
+
+    private:
+        /**
+         * Executes the shots with indices from first_shot up to but excluding last_shot on one worker thread,
+         * adding their results to the worker's histogram and the number of finished shots to the counter.
+         */
+        using Worker = std::function<void(uint first_shot, uint last_shot, Histogram &histogram,
+                                          std::atomic<uint> &completed_shots)>;
+
+        /**
+         * Distribute the shots evenly across the worker threads, report progress and merge the histograms.
+         * Exceptions thrown by a worker are rethrown on the calling thread.
+         * @param num_shots Number of shots to execute.
+         * @param num_threads Number of worker threads. 0 selects the number of hardware threads.
+         * @param progress Optional callback, invoked periodically from the calling thread.
+         * @param work The work of a single worker.
+         * @return Histogram of the measurement strings of all shots.
+         */
+        static Histogram runWorkers(uint num_shots, uint num_threads, const ProgressCallback &progress,
+                                    const Worker &work);
+    };
+}
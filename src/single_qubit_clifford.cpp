@@ -0,0 +1,125 @@
+#include "single_qubit_clifford.h"
+#include "improved_simulation_of_stabilizer_circuits/subroutines.h"
+
+#include <deque>
+#include <string>
+#include <stdexcept>
+
+namespace CliffordTableaus {
+    namespace {
+        /**
+         * Indices of the Paulis within SingleQubitClifford::image, given by their tableau bits (x << 1) | z.
+         */
+        constexpr uint8_t PAULI_I_INDEX = 0b00;
+        constexpr uint8_t PAULI_Z_INDEX = 0b01;
+        constexpr uint8_t PAULI_X_INDEX = 0b10;
+        constexpr uint8_t PAULI_Y_INDEX = 0b11;
+
+        constexpr uint8_t NEGATIVE = 0b100;
+
+        /**
+         * Build a Clifford from the images of X and Z, deriving the image of Y = iXZ.
+         * @return Whether the images belong to a Clifford, i.e. they are anticommuting non-identity Paulis.
+         */
+        bool fromImages(uint8_t image_x, uint8_t image_z, SingleQubitClifford &clifford) {
+            auto pauli_x = image_x & 0b11;
+            auto pauli_z = image_z & 0b11;
+            if (pauli_x == PAULI_I_INDEX || pauli_z == PAULI_I_INDEX || pauli_x == pauli_z || image_x > 0b111 ||
+                image_z > 0b111) {
+                return false;
+            }
+            // i * P * Q = i^(1 + g(P, Q)) * (P xor Q), and the exponent is 0 or 2 since P and Q anticommute.
+            auto exponent = 1 + g(pauli_x >> 1, pauli_x & 1, pauli_z >> 1, pauli_z & 1);
+            uint8_t sign = ((image_x ^ image_z) & NEGATIVE) ^ ((((exponent % 4) + 4) % 4 == 2) ? NEGATIVE : 0);
+            clifford.image = {PAULI_I_INDEX, image_z, image_x, static_cast<uint8_t>(sign | (pauli_x ^ pauli_z))};
+            return true;
+        }
+
+        /**
+         * The shortest decompositions of all 64 codes, found once by breadth-first search over the generating gates.
+         */
+        const std::array<std::vector<Gate>, 64> &decompositions() {
+            static const auto table = [] {
+                std::array<std::vector<Gate>, 64> words{};
+                std::array<bool, 64> found{};
+                std::deque<SingleQubitClifford> queue{SingleQubitClifford::identity()};
+                found[SingleQubitClifford::identity().code()] = true;
+                while (!queue.empty()) {
+                    auto clifford = queue.front();
+                    queue.pop_front();
+                    for (auto gate: {HADAMARD, PHASE, PAULI_X, PAULI_Y, PAULI_Z}) {
+                        auto next = clifford.then(SingleQubitClifford::fromInstruction({gate, 0, 0}));
+                        if (!found[next.code()]) {
+                            found[next.code()] = true;
+                            words[next.code()] = words[clifford.code()];
+                            words[next.code()].push_back(gate);
+                            queue.push_back(next);
+                        }
+                    }
+                }
+                return words;
+            }();
+            return table;
+        }
+    }
+
+    SingleQubitClifford SingleQubitClifford::identity() {
+        return {{PAULI_I_INDEX, PAULI_Z_INDEX, PAULI_X_INDEX, PAULI_Y_INDEX}};
+    }
+
+    SingleQubitClifford SingleQubitClifford::fromInstruction(const Instruction &instruction) {
+        switch (instruction.gate) {
+            case IDENTITY:
+                return identity();
+            case PAULI_X:
+                // X → X, Z → -Z, Y → -Y
+                return {{PAULI_I_INDEX, NEGATIVE | PAULI_Z_INDEX, PAULI_X_INDEX, NEGATIVE | PAULI_Y_INDEX}};
+            case PAULI_Y:
+                // X → -X, Z → -Z, Y → Y
+                return {{PAULI_I_INDEX, NEGATIVE | PAULI_Z_INDEX, NEGATIVE | PAULI_X_INDEX, PAULI_Y_INDEX}};
+            case PAULI_Z:
+                // X → -X, Z → Z, Y → -Y
+                return {{PAULI_I_INDEX, PAULI_Z_INDEX, NEGATIVE | PAULI_X_INDEX, NEGATIVE | PAULI_Y_INDEX}};
+            case HADAMARD:
+                // X → Z, Z → X, Y → -Y
+                return {{PAULI_I_INDEX, PAULI_X_INDEX, PAULI_Z_INDEX, NEGATIVE | PAULI_Y_INDEX}};
+            case PHASE:
+                // X → Y, Z → Z, Y → -X
+                return {{PAULI_I_INDEX, PAULI_Z_INDEX, PAULI_Y_INDEX, NEGATIVE | PAULI_X_INDEX}};
+            case CLIFFORD:
+                return fromCode(instruction.qubit2);
+            default:
+                throw std::invalid_argument("Not a single-qubit Clifford gate.");
+        }
+    }
+
+    SingleQubitClifford SingleQubitClifford::fromCode(uint32_t code) {
+        SingleQubitClifford clifford{};
+        if (code > 0b111111 || !fromImages(code & 0b111, code >> 3, clifford)) {
+            throw std::invalid_argument("Invalid single-qubit Clifford code " + std::to_string(code) + ".");
+        }
+        return clifford;
+    }
+
+    uint32_t SingleQubitClifford::code() const {
+        return image[PAULI_X_INDEX] | (image[PAULI_Z_INDEX] << 3);
+    }
+
+    SingleQubitClifford SingleQubitClifford::then(const SingleQubitClifford &next) const {
+        SingleQubitClifford composed{};
+        for (uint8_t pauli = 0; pauli < 4; ++pauli) {
+            auto first = image[pauli];
+            auto second = next.image[first & 0b11];
+            composed.image[pauli] = ((first ^ second) & NEGATIVE) | (second & 0b11);
+        }
+        return composed;
+    }
+
+    bool SingleQubitClifford::isIdentity() const {
+        return *this == identity();
+    }
+
+    const std::vector<Gate> &SingleQubitClifford::decomposition() const {
+        return decompositions()[code()];
+    }
+}
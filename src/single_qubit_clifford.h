@@ -0,0 +1,73 @@
+#pragma once
+
+#include "circuit_instruction.h"
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace CliffordTableaus {
+    /**
+     * One of the 24 single-qubit Clifford gates, up to a global phase.
+     * A Clifford C is fully determined by how it maps the Pauli operators under conjugation, P → C P C†.
+     * The images are stored for all four Paulis, indexed by the tableau bits (x << 1) | z of the Pauli
+     * (0: I, 1: Z, 2: X, 3: Y), as (sign << 2) | (x' << 1) | z' of the image.
+     * Applying C to a qubit a of a generator therefore amounts to ri ^= sign and (xia, zia) = (x', z').
+     */
+    struct SingleQubitClifford {
+        /**
+         * The images of I, Z, X and Y.
+         */
+        std::array<uint8_t, 4> image;
+
+        /**
+         * Get the identity.
+         * @return The identity gate.
+         */
+        static SingleQubitClifford identity();
+
+        /**
+         * Get the Clifford of a single-qubit gate: IDENTITY, PAULI_X, PAULI_Y, PAULI_Z, HADAMARD, PHASE or CLIFFORD.
+         * Throws an invalid argument exception for any other gate.
+         * @param instruction Instruction applying the gate.
+         * @return The Clifford of the gate.
+         */
+        static SingleQubitClifford fromInstruction(const Instruction &instruction);
+
+        /**
+         * Decode a Clifford from its code, see code().
+         * Throws an invalid argument exception if the code does not belong to a Clifford.
+         * @param code The code of the Clifford.
+         * @return The decoded Clifford.
+         */
+        static SingleQubitClifford fromCode(uint32_t code);
+
+        /**
+         * Encode the Clifford into 6 bits: the image of X followed by the image of Z, 3 bits each.
+         * The image of Y follows from Y = iXZ.
+         * @return The code of the Clifford.
+         */
+        [[nodiscard]] uint32_t code() const;
+
+        /**
+         * Compose two Cliffords.
+         * @param next The Clifford applied after this one.
+         * @return The Clifford applying this one first and then next.
+         */
+        [[nodiscard]] SingleQubitClifford then(const SingleQubitClifford &next) const;
+
+        /**
+         * Check whether the Clifford is the identity.
+         * @return Whether the Clifford is the identity.
+         */
+        [[nodiscard]] bool isIdentity() const;
+
+        /**
+         * Decompose the Clifford into a shortest sequence of the gates PAULI_X, PAULI_Y, PAULI_Z, HADAMARD and PHASE.
+         * @return The gates in order of application. Empty for the identity.
+         */
+        [[nodiscard]] const std::vector<Gate> &decomposition() const;
+
+        bool operator==(const SingleQubitClifford &other) const = default;
+    };
+}
@@ -0,0 +1,637 @@
+#include "sparse_stabilizer_tableau.h"
+#include "stim_a_fast_stabilizer_circuit_simulator/simd_kernels.h"
+
+#include <algorithm>
+#include <bit>
+
+namespace CliffordTableaus {
+    namespace {
+        constexpr uint8_t PAULI_X_BIT = 0b10;
+        constexpr uint8_t PAULI_Z_BIT = 0b01;
+
+        uint8_t x_of(uint8_t pauli) {
+            return pauli >> 1;
+        }
+
+        uint8_t z_of(uint8_t pauli) {
+            return pauli & PAULI_Z_BIT;
+        }
+    }
+
+    void SparseStabilizerTableau::initializeTableau(uint p_n) {
+        StabilizerTableau::initializeTableau(p_n, 0);
+        qubit_words = (p_n + 63) / 64;
+        // A dense generator occupies as much memory as a sparse one with a support of 2 * qubit_words.
+        dense_threshold = std::max<uint>(2 * qubit_words, 8);
+        // The generators and the lists of the qubits are cleared rather than replaced,
+        // so that repeated shots reuse their storage.
+        generators.resize(2 * n + 1);
+        for (auto &generator: generators) {
+            generator.entries.clear();
+            generator.words.clear();
+            generator.dense = false;
+            generator.support = 0;
+            generator.r = 0;
+        }
+        columns.resize(n);
+        for (auto &column: columns) {
+            column.clear();
+        }
+        dense_generators.clear();
+        // The initial state |0〉^⊗n has the destabilizers X_i and the stabilizers Z_i.
+        for (uint i = 1; i <= n; ++i) {
+            set_pauli(i, i, PAULI_X_BIT);
+            set_pauli(n + i, i, PAULI_Z_BIT);
+        }
+    }
+
+    uint8_t SparseStabilizerTableau::get_pauli(const Generator &generator, uint j) const {
+        if (generator.dense) {
+            auto word = (j - 1) / 64;
+            auto shift = (j - 1) % 64;
+            return static_cast<uint8_t>((((generator.words[word] >> shift) & 1) << 1) |
+                                        ((generator.words[qubit_words + word] >> shift) & 1));
+        }
+        auto entry = std::lower_bound(
+                generator.entries.begin(), generator.entries.end(), j,
+                [](const Entry &e, uint qubit) { return e.qubit < qubit; }
+        );
+        return entry != generator.entries.end() && entry->qubit == j ? entry->pauli : 0;
+    }
+
+    void SparseStabilizerTableau::set_pauli(uint i, uint j, uint8_t pauli) {
+        auto &generator = generators[i - 1];
+        if (generator.dense) {
+            auto word = (j - 1) / 64;
+            auto shift = (j - 1) % 64;
+            auto before = get_pauli(generator, j);
+            generator.words[word] ^= static_cast<uint64_t>(x_of(before) ^ x_of(pauli)) << shift;
+            generator.words[qubit_words + word] ^= static_cast<uint64_t>(z_of(before) ^ z_of(pauli)) << shift;
+            updateSupport(i, j, before, pauli);
+        } else {
+            auto &entries = generator.entries;
+            auto entry = std::lower_bound(
+                    entries.begin(), entries.end(), j,
+                    [](const Entry &e, uint qubit) { return e.qubit < qubit; }
+            );
+            uint8_t before = entry != entries.end() && entry->qubit == j ? entry->pauli : 0;
+            if (before == 0 && pauli != 0) {
+                entries.insert(entry, {static_cast<uint32_t>(j), pauli});
+            } else if (before != 0 && pauli == 0) {
+                entries.erase(entry);
+            } else if (before != 0) {
+                entry->pauli = pauli;
+            }
+            updateSupport(i, j, before, pauli);
+        }
+        adaptForm(i);
+    }
+
+    void SparseStabilizerTableau::updateSupport(uint i, uint j, uint8_t before, uint8_t after) {
+        if ((before == 0) == (after == 0)) {
+            return;
+        }
+        auto &generator = generators[i - 1];
+        if (before == 0) {
+            ++generator.support;
+        } else {
+            --generator.support;
+        }
+        if (generator.dense || i > 2 * n) {
+            return;
+        }
+        auto &column = columns[j - 1];
+        if (before == 0) {
+            column.push_back(static_cast<uint32_t>(i));
+        } else {
+            auto position = std::find(column.begin(), column.end(), static_cast<uint32_t>(i));
+            *position = column.back();
+            column.pop_back();
+        }
+    }
+
+    void SparseStabilizerTableau::listGenerator(uint i) {
+        if (i > 2 * n) {
+            return;
+        }
+        if (generators[i - 1].dense) {
+            dense_generators.push_back(static_cast<uint32_t>(i));
+            return;
+        }
+        for (const auto &entry: generators[i - 1].entries) {
+            columns[entry.qubit - 1].push_back(static_cast<uint32_t>(i));
+        }
+    }
+
+    void SparseStabilizerTableau::unlistGenerator(uint i) {
+        if (i > 2 * n) {
+            return;
+        }
+        auto remove = [i](std::vector<uint32_t> &list) {
+            auto position = std::find(list.begin(), list.end(), static_cast<uint32_t>(i));
+            *position = list.back();
+            list.pop_back();
+        };
+        if (generators[i - 1].dense) {
+            remove(dense_generators);
+            return;
+        }
+        for (const auto &entry: generators[i - 1].entries) {
+            remove(columns[entry.qubit - 1]);
+        }
+    }
+
+    void SparseStabilizerTableau::adaptForm(uint i) {
+        auto &generator = generators[i - 1];
+        if (!generator.dense && generator.support > dense_threshold) {
+            makeDense(i);
+        } else if (generator.dense && 2 * generator.support < dense_threshold) {
+            unlistGenerator(i);
+            generator.entries.clear();
+            forEachPauli(generator, [&](uint j, uint8_t pauli) {
+                generator.entries.push_back({static_cast<uint32_t>(j), pauli});
+            });
+            generator.words.clear();
+            generator.dense = false;
+            listGenerator(i);
+        }
+    }
+
+    void SparseStabilizerTableau::makeDense(uint i) {
+        auto &generator = generators[i - 1];
+        unlistGenerator(i);
+        generator.words.assign(2 * qubit_words, 0);
+        for (const auto &entry: generator.entries) {
+            auto word = (entry.qubit - 1) / 64;
+            auto shift = (entry.qubit - 1) % 64;
+            generator.words[word] |= static_cast<uint64_t>(x_of(entry.pauli)) << shift;
+            generator.words[qubit_words + word] |= static_cast<uint64_t>(z_of(entry.pauli)) << shift;
+        }
+        generator.entries.clear();
+        generator.dense = true;
+        listGenerator(i);
+    }
+
+    template<class Visit>
+    void SparseStabilizerTableau::forEachPauli(const Generator &generator, Visit visit) const {
+        if (!generator.dense) {
+            for (const auto &entry: generator.entries) {
+                visit(entry.qubit, entry.pauli);
+            }
+            return;
+        }
+        for (uint word = 0; word < qubit_words; ++word) {
+            auto x = generator.words[word];
+            auto z = generator.words[qubit_words + word];
+            for (auto support = x | z; support != 0; support &= support - 1) {
+                auto shift = std::countr_zero(support);
+                visit(word * 64 + shift + 1,
+                      static_cast<uint8_t>((((x >> shift) & 1) << 1) | ((z >> shift) & 1)));
+            }
+        }
+    }
+
+    void SparseStabilizerTableau::clearGenerator(uint i) {
+        auto &generator = generators[i - 1];
+        unlistGenerator(i);
+        generator.entries.clear();
+        generator.words.clear();
+        generator.dense = false;
+        generator.support = 0;
+        generator.r = 0;
+    }
+
+    void SparseStabilizerTableau::copyGenerator(uint destination, uint source) {
+        unlistGenerator(destination);
+        generators[destination - 1] = generators[source - 1];
+        listGenerator(destination);
+    }
+
+    template<class Visit>
+    void SparseStabilizerTableau::forEachGeneratorOn(uint j, Visit visit) {
+        for (auto i: columns[j - 1]) {
+            visit(i, generators[i - 1], get_pauli(generators[i - 1], j));
+        }
+        for (auto i: dense_generators) {
+            auto pauli = get_pauli(generators[i - 1], j);
+            if (pauli != 0) {
+                visit(i, generators[i - 1], pauli);
+            }
+        }
+    }
+
+    template<class Condition>
+    void SparseStabilizerTableau::collectAffected(uint j, Condition condition) {
+        forEachGeneratorOn(j, [&](uint i, Generator &, uint8_t pauli) {
+            if (condition(pauli)) {
+                affected.push_back(static_cast<uint32_t>(i));
+            }
+        });
+    }
+
+    void SparseStabilizerTableau::rowsum(uint h, uint i) {
+        auto &generator_h = generators[h - 1];
+        const auto &generator_i = generators[i - 1];
+        int sum_g = 2 * (generator_h.r + generator_i.r);
+
+        if (!generator_h.dense && !generator_i.dense) {
+            // Merge both sorted lists of Paulis.
+            merged.clear();
+            auto entry_h = generator_h.entries.begin();
+            auto end_h = generator_h.entries.end();
+            for (const auto &entry_i: generator_i.entries) {
+                while (entry_h != end_h && entry_h->qubit < entry_i.qubit) {
+                    merged.push_back(*entry_h++);
+                }
+                uint8_t pauli_h = 0;
+                if (entry_h != end_h && entry_h->qubit == entry_i.qubit) {
+                    pauli_h = (entry_h++)->pauli;
+                }
+                sum_g += g(x_of(entry_i.pauli), z_of(entry_i.pauli), x_of(pauli_h), z_of(pauli_h));
+                auto pauli = static_cast<uint8_t>(pauli_h ^ entry_i.pauli);
+                if (pauli != 0) {
+                    merged.push_back({entry_i.qubit, pauli});
+                }
+                updateSupport(h, entry_i.qubit, pauli_h, pauli);
+            }
+            merged.insert(merged.end(), entry_h, end_h);
+            std::swap(generator_h.entries, merged);
+        } else {
+            if (!generator_h.dense) {
+                // The sum with a dense generator is usually dense, so h takes the dense form right away.
+                makeDense(h);
+            }
+            auto x_h = generator_h.words.data();
+            auto z_h = x_h + qubit_words;
+            if (!generator_i.dense) {
+                for (const auto &entry_i: generator_i.entries) {
+                    auto word = (entry_i.qubit - 1) / 64;
+                    auto shift = (entry_i.qubit - 1) % 64;
+                    auto pauli_h = get_pauli(generator_h, entry_i.qubit);
+                    sum_g += g(x_of(entry_i.pauli), z_of(entry_i.pauli), x_of(pauli_h), z_of(pauli_h));
+                    x_h[word] ^= static_cast<uint64_t>(x_of(entry_i.pauli)) << shift;
+                    z_h[word] ^= static_cast<uint64_t>(z_of(entry_i.pauli)) << shift;
+                    updateSupport(h, entry_i.qubit, pauli_h, pauli_h ^ entry_i.pauli);
+                }
+            } else {
+                auto x_i = generator_i.words.data();
+                auto z_i = x_i + qubit_words;
+                sum_g += simd_kernels().g_packed(x_i, z_i, x_h, z_h, qubit_words);
+                // Dense generators are not listed per qubit, only their support needs to be recounted.
+                generator_h.support = 0;
+                for (uint word = 0; word < qubit_words; ++word) {
+                    x_h[word] ^= x_i[word];
+                    z_h[word] ^= z_i[word];
+                    generator_h.support += std::popcount(x_h[word] | z_h[word]);
+                }
+            }
+        }
+
+        sum_g = ((sum_g % 4) + 4) % 4;
+        if (sum_g == 0) {
+            generator_h.r = 0;
+        } else if (sum_g == 2) {
+            generator_h.r = 1;
+        } else {
+            throw std::logic_error("Sum_g should never be congruent to 1 or 3.");
+        }
+        adaptForm(h);
+    }
+
+    void SparseStabilizerTableau::CNOT(uint control, uint target) {
+        if (control == 0) {
+            std::cerr << "Attempted to apply CNOT with control = 0!" << std::endl;
+            return;
+        }
+        if (control > n) {
+            std::cerr << "Attempted to apply CNOT with control > n!" << std::endl;
+            return;
+        }
+        if (target == 0) {
+            std::cerr << "Attempted to apply CNOT with target = 0!" << std::endl;
+            return;
+        }
+        if (target > n) {
+            std::cerr << "Attempted to apply CNOT with target > n!" << std::endl;
+            return;
+        }
+        if (control == target) {
+            std::cerr << "Attempted to apply CNOT with target = control!" << std::endl;
+            return;
+        }
+
+        // Only generators with xia = 1 or zib = 1 change.
+        auto a = control;
+        auto b = target;
+        affected.clear();
+        collectAffected(a, [](uint8_t pauli) { return x_of(pauli) == 1; });
+        collectAffected(b, [](uint8_t pauli) { return z_of(pauli) == 1; });
+        std::sort(affected.begin(), affected.end());
+        affected.erase(std::unique(affected.begin(), affected.end()), affected.end());
+        for (auto i: affected) {
+            auto &generator = generators[i - 1];
+            auto pauli_a = get_pauli(generator, a);
+            auto pauli_b = get_pauli(generator, b);
+            auto xia = x_of(pauli_a), zia = z_of(pauli_a);
+            auto xib = x_of(pauli_b), zib = z_of(pauli_b);
+            generator.r ^= xia & zib & (xib ^ zia ^ 1);
+            set_pauli(i, b, static_cast<uint8_t>(((xib ^ xia) << 1) | zib));
+            set_pauli(i, a, static_cast<uint8_t>((xia << 1) | (zia ^ zib)));
+        }
+    }
+
+    void SparseStabilizerTableau::Hadamard(uint qubit) {
+        if (qubit == 0) {
+            std::cerr << "Attempted to apply Hadamard with qubit = 0!" << std::endl;
+            return;
+        }
+        if (qubit > n) {
+            std::cerr << "Attempted to apply Hadamard with qubit > n!" << std::endl;
+            return;
+        }
+
+        // The support does not change, so the column can be iterated directly.
+        auto a = qubit;
+        forEachGeneratorOn(a, [&](uint i, Generator &generator, uint8_t pauli) {
+            generator.r ^= x_of(pauli) & z_of(pauli);
+            set_pauli(i, a, static_cast<uint8_t>((z_of(pauli) << 1) | x_of(pauli)));
+        });
+    }
+
+    void SparseStabilizerTableau::Phase(uint qubit) {
+        if (qubit == 0) {
+            std::cout << "Attempted to apply Phase with qubit = 0!" << std::endl;
+            return;
+        }
+        if (qubit > n) {
+            std::cout << "Attempted to apply Phase with qubit > n!" << std::endl;
+            return;
+        }
+
+        auto a = qubit;
+        forEachGeneratorOn(a, [&](uint i, Generator &generator, uint8_t pauli) {
+            generator.r ^= x_of(pauli) & z_of(pauli);
+            set_pauli(i, a, static_cast<uint8_t>(pauli ^ x_of(pauli)));
+        });
+    }
+
+    uint8_t SparseStabilizerTableau::Measurement(uint qubit) {
+        if (qubit == 0) {
+            throw std::invalid_argument("Attempted to measure qubit = 0!");
+        }
+        if (qubit > n) {
+            throw std::invalid_argument("Attempted to measure qubit > n!");
+        }
+
+        // Measurement of qubit a in standard basis, see ImprovedStabilizerTableau::Measurement.
+        // The generators with xia = 1 are exactly those listed for qubit a with an X or Y on it.
+        auto a = qubit;
+        affected.clear();
+        collectAffected(a, [](uint8_t pauli) { return x_of(pauli) == 1; });
+        uint p = 2 * n + 1;
+        for (auto i: affected) {
+            if (i > n && i < p) {
+                p = i;
+            }
+        }
+
+        if (p <= 2 * n) {
+            // Case I: The outcome is random.
+            // rowsum modifies the lists of the qubits but not the collected generators.
+            for (auto i: affected) {
+                if (i != p && i != p - n) {
+                    rowsum(i, p);
+                }
+            }
+            copyGenerator(p - n, p);
+            clearGenerator(p);
+            generators[p - 1].r = randomBit();
+            set_pauli(p, a, PAULI_Z_BIT);
+            return generators[p - 1].r;
+        }
+
+        // Case II: The outcome is determinate and given by the product of the stabilizers
+        // whose destabilizers anticommute with Z_a, accumulated in the scratch space.
+        auto scratch = 2 * n + 1;
+        clearGenerator(scratch);
+        for (auto i: affected) {
+            rowsum(scratch, i + n);
+        }
+        return generators[scratch - 1].r;
+    }
+
+    void SparseStabilizerTableau::PauliX(uint qubit) {
+        if (qubit == 0) {
+            std::cerr << "Warning: Attempted to apply Pauli-X with qubit = 0!" << std::endl;
+            return;
+        }
+        if (qubit > n) {
+            std::cerr << "Warning: Attempted to apply Pauli-X with qubit > n!" << std::endl;
+            return;
+        }
+        // X anticommutes with Z and Y, so it flips the sign of every generator with zia = 1.
+        forEachGeneratorOn(qubit, [](uint, Generator &generator, uint8_t pauli) {
+            generator.r ^= z_of(pauli);
+        });
+    }
+
+    void SparseStabilizerTableau::PauliY(uint qubit) {
+        if (qubit == 0) {
+            std::cerr << "Warning: Attempted to apply Pauli-Y with qubit = 0!" << std::endl;
+            return;
+        }
+        if (qubit > n) {
+            std::cerr << "Warning: Attempted to apply Pauli-Y with qubit > n!" << std::endl;
+            return;
+        }
+        // Y anticommutes with X and Z, so it flips the sign of every generator with xia ^ zia = 1.
+        forEachGeneratorOn(qubit, [](uint, Generator &generator, uint8_t pauli) {
+            generator.r ^= x_of(pauli) ^ z_of(pauli);
+        });
+    }
+
+    void SparseStabilizerTableau::PauliZ(uint qubit) {
+        if (qubit == 0) {
+            std::cerr << "Warning: Attempted to apply Pauli-Z with qubit = 0!" << std::endl;
+            return;
+        }
+        if (qubit > n) {
+            std::cerr << "Warning: Attempted to apply Pauli-Z with qubit > n!" << std::endl;
+            return;
+        }
+        // Z anticommutes with X and Y, so it flips the sign of every generator with xia = 1.
+        forEachGeneratorOn(qubit, [](uint, Generator &generator, uint8_t pauli) {
+            generator.r ^= x_of(pauli);
+        });
+    }
+
+    void SparseStabilizerTableau::SWAP(uint qubit1, uint qubit2) {
+        if (qubit1 == 0) {
+            std::cerr << "Attempted to apply SWAP with qubit1 = 0!" << std::endl;
+            return;
+        }
+        if (qubit1 > n) {
+            std::cerr << "Attempted to apply SWAP with qubit1 > n!" << std::endl;
+            return;
+        }
+        if (qubit2 == 0) {
+            std::cerr << "Attempted to apply SWAP with qubit2 = 0!" << std::endl;
+            return;
+        }
+        if (qubit2 > n) {
+            std::cerr << "Attempted to apply SWAP with qubit2 > n!" << std::endl;
+            return;
+        }
+        if (qubit1 == qubit2) {
+            return;
+        }
+
+        affected.clear();
+        collectAffected(qubit1, [](uint8_t) { return true; });
+        collectAffected(qubit2, [](uint8_t) { return true; });
+        std::sort(affected.begin(), affected.end());
+        affected.erase(std::unique(affected.begin(), affected.end()), affected.end());
+        for (auto i: affected) {
+            auto pauli1 = get_pauli(generators[i - 1], qubit1);
+            auto pauli2 = get_pauli(generators[i - 1], qubit2);
+            set_pauli(i, qubit1, pauli2);
+            set_pauli(i, qubit2, pauli1);
+        }
+    }
+
+    void SparseStabilizerTableau::Clifford(uint qubit, const SingleQubitClifford &clifford) {
+        if (qubit == 0) {
+            std::cerr << "Warning: Attempted to apply Clifford with qubit = 0!" << std::endl;
+            return;
+        }
+        if (qubit > n) {
+            std::cerr << "Warning: Attempted to apply Clifford with qubit > n!" << std::endl;
+            return;
+        }
+
+        // A Clifford maps non-trivial Paulis to non-trivial Paulis, so the support does not change.
+        forEachGeneratorOn(qubit, [&](uint i, Generator &generator, uint8_t pauli) {
+            auto image = clifford.image[pauli];
+            generator.r ^= image >> 2;
+            set_pauli(i, qubit, image & 0b11);
+        });
+    }
+
+    void SparseStabilizerTableau::saveSnapshot(TableauSnapshot &snapshot) const {
+        // Every generator is written as one word holding its phase bit and support,
+        // followed by one word (j << 2) | pauli per qubit of its support.
+        snapshot.n = n;
+        snapshot.total_bits = total_bits;
+        snapshot.words.clear();
+        for (uint i = 1; i <= 2 * n; ++i) {
+            const auto &generator = generators[i - 1];
+            snapshot.words.push_back(generator.r | (static_cast<uint64_t>(generator.support) << 1));
+            forEachPauli(generator, [&](uint j, uint8_t pauli) {
+                snapshot.words.push_back((static_cast<uint64_t>(j) << 2) | pauli);
+            });
+        }
+    }
+
+    void SparseStabilizerTableau::restoreSnapshot(const TableauSnapshot &snapshot) {
+        if (snapshot.n != n || generators.size() != 2 * n + 1) {
+            initializeTableau(snapshot.n);
+        }
+        total_bits = snapshot.total_bits;
+        for (auto &column: columns) {
+            column.clear();
+        }
+        dense_generators.clear();
+        auto word = snapshot.words.begin();
+        for (uint i = 1; i <= 2 * n; ++i) {
+            auto &generator = generators[i - 1];
+            generator.r = *word & 1;
+            generator.support = *word++ >> 1;
+            generator.entries.clear();
+            generator.words.clear();
+            generator.dense = false;
+            for (uint k = 0; k < generator.support; ++k, ++word) {
+                generator.entries.push_back({static_cast<uint32_t>(*word >> 2), static_cast<uint8_t>(*word & 0b11)});
+            }
+            listGenerator(i);
+            adaptForm(i);
+        }
+        clearGenerator(2 * n + 1);
+    }
+
+    bool SparseStabilizerTableau::hasRandomOutcome(uint qubit) {
+        if (qubit == 0) {
+            throw std::invalid_argument("Attempted to measure qubit = 0!");
+        }
+        if (qubit > n) {
+            throw std::invalid_argument("Attempted to measure qubit > n!");
+        }
+        // Same check as the first step of Measurement.
+        bool random = false;
+        forEachGeneratorOn(qubit, [&](uint i, Generator &, uint8_t pauli) {
+            random = random || (i > n && x_of(pauli) == 1);
+        });
+        return random;
+    }
+
+    OutcomeSpace SparseStabilizerTableau::outcomeSpace() {
+        // The dense rows use the layout of the improved tableau: x words, z words and the phase bit.
+        auto row_words = 2 * qubit_words + 1;
+        std::vector<uint64_t> stabilizers(n * row_words, 0);
+        for (uint i = n + 1; i <= 2 * n; ++i) {
+            auto row = stabilizers.data() + (i - n - 1) * row_words;
+            forEachPauli(generators[i - 1], [&](uint j, uint8_t pauli) {
+                row[(j - 1) / 64] |= static_cast<uint64_t>(x_of(pauli)) << ((j - 1) % 64);
+                row[qubit_words + (j - 1) / 64] |= static_cast<uint64_t>(z_of(pauli)) << ((j - 1) % 64);
+            });
+            row[2 * qubit_words] = generators[i - 1].r;
+        }
+        return reduceOutcomeSpace(stabilizers, qubit_words);
+    }
+
+    uint SparseStabilizerTableau::support(uint i) const {
+        if (i == 0 || i > 2 * n) {
+            throw std::invalid_argument("Invalid index for support.");
+        }
+        return generators[i - 1].support;
+    }
+
+    void SparseStabilizerTableau::check_indices(uint i, uint j, const std::string &message) const {
+        if (i == 0 || j == 0 || i > 2 * n || j > n) {
+            throw std::invalid_argument(message);
+        }
+    }
+
+    void SparseStabilizerTableau::set_x(uint i, uint j, uint8_t x) {
+        check_indices(i, j, "Invalid indices for set_x.");
+        set_pauli(i, j, static_cast<uint8_t>(((x & 1) << 1) | z_of(get_pauli(generators[i - 1], j))));
+    }
+
+    void SparseStabilizerTableau::set_z(uint i, uint j, uint8_t z) {
+        check_indices(i, j, "Invalid indices for set_z.");
+        set_pauli(i, j, static_cast<uint8_t>((x_of(get_pauli(generators[i - 1], j)) << 1) | (z & 1)));
+    }
+
+    void SparseStabilizerTableau::set_r(uint i, uint8_t r) {
+        if (i == 0 || i > 2 * n) {
+            throw std::invalid_argument("Invalid index for set_r.");
+        }
+        generators[i - 1].r = r & 1;
+    }
+
+    uint8_t SparseStabilizerTableau::get_x(uint i, uint j) {
+        check_indices(i, j, "Invalid indices for get_x.");
+        return x_of(get_pauli(generators[i - 1], j));
+    }
+
+    uint8_t SparseStabilizerTableau::get_z(uint i, uint j) {
+        check_indices(i, j, "Invalid indices for get_z.");
+        return z_of(get_pauli(generators[i - 1], j));
+    }
+
+    uint8_t SparseStabilizerTableau::get_r(uint i) {
+        if (i == 0 || i > 2 * n) {
+            throw std::invalid_argument("Invalid index for get_r.");
+        }
+        return generators[i - 1].r;
+    }
+}
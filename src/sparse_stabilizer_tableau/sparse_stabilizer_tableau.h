@@ -0,0 +1,306 @@
+#pragma once
+
+#include "improved_simulation_of_stabilizer_circuits/subroutines.h"
+#include "stabilizer_tableau.h"
+
+#include <iostream>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+namespace CliffordTableaus {
+    using uint = std::size_t;
+
+    /**
+     * Stabilizer tableau for wide circuits with little entanglement, where most generators act non-trivially
+     * on only a few qubits. Every generator is stored on its own, either as a sorted list of the qubits it acts on
+     * together with their Paulis, or, once its support grows beyond a threshold, as dense x and z bitsets.
+     * Generators switch back to the sparse form when their support shrinks again.
+     * In addition, every qubit keeps the list of sparse generators acting on it, so that a gate only visits these
+     * and the dense generators instead of all 2n generators.
+     * The cost of the gates and of rowsum therefore scales with the support of the generators involved,
+     * while the dense form bounds the cost of highly entangled generators by that of the improved tableau.
+     * The dense tableau of the base class is not used.
+     */
+    class SparseStabilizerTableau : public StabilizerTableau {
+    private:
+        /**
+         * A non-trivial Pauli of a sparse generator: the qubit and its bits (x << 1) | z, which are never 0.
+         */
+        struct Entry {
+            uint32_t qubit;
+            uint8_t pauli;
+        };
+
+        /**
+         * One generator in either the sparse or the dense form.
+         */
+        struct Generator {
+            /**
+             * Sparse form: the non-trivial Paulis sorted by qubit.
+             */
+            std::vector<Entry> entries;
+
+            /**
+             * Dense form: the x words of all qubits followed by the z words of all qubits.
+             */
+            std::vector<uint64_t> words;
+
+            /**
+             * Whether the generator is stored in the dense form.
+             */
+            bool dense = false;
+
+            /**
+             * The number of qubits on which the generator acts non-trivially.
+             */
+            uint support = 0;
+
+            /**
+             * The phase bit.
+             */
+            uint8_t r = 0;
+        };
+
+        /**
+         * The number of 64-bit words needed to store the x (or z) bits of one dense generator.
+         */
+        uint qubit_words{};
+
+        /**
+         * Generators with a larger support are stored in the dense form,
+         * generators with less than half of it in the sparse form.
+         */
+        uint dense_threshold{};
+
+        /**
+         * The 2n generators followed by the scratch space, generator i is stored at index i - 1.
+         */
+        std::vector<Generator> generators;
+
+        /**
+         * For every qubit j the indices of the sparse generators among 1 to 2n acting non-trivially on it,
+         * stored at index j - 1. The scratch space is never listed.
+         */
+        std::vector<std::vector<uint32_t>> columns;
+
+        /**
+         * The indices of the dense generators among 1 to 2n. They are visited by every gate, which keeps the
+         * lists of the qubits short and spares the dense rowsum from updating them bit by bit.
+         */
+        std::vector<uint32_t> dense_generators;
+
+        /**
+         * Reused storage for the generators affected by an operation.
+         */
+        std::vector<uint32_t> affected;
+
+        /**
+         * Reused storage for the result of a sparse rowsum.
+         */
+        std::vector<Entry> merged;
+
+        /**
+         * Get the Pauli of a generator on a qubit.
+         * @param generator The generator.
+         * @param j Index of the qubit.
+         * @return The bits (x << 1) | z of the Pauli.
+         */
+        [[nodiscard]] uint8_t get_pauli(const Generator &generator, uint j) const;
+
+        /**
+         * Set the Pauli of a generator on a qubit, keeping the support and the column lists up to date.
+         * @param i Index of the generator.
+         * @param j Index of the qubit.
+         * @param pauli The bits (x << 1) | z of the Pauli.
+         */
+        void set_pauli(uint i, uint j, uint8_t pauli);
+
+        /**
+         * Account for a qubit entering or leaving the support of a generator, listing sparse generators accordingly.
+         * @param i Index of the generator.
+         * @param j Index of the qubit.
+         * @param before The Pauli of the generator on the qubit before the change.
+         * @param after The Pauli of the generator on the qubit after the change.
+         */
+        void updateSupport(uint i, uint j, uint8_t before, uint8_t after);
+
+        /**
+         * Add a generator to the lists of its qubits, or to dense_generators if it is dense.
+         * @param i Index of the generator.
+         */
+        void listGenerator(uint i);
+
+        /**
+         * Remove a generator from the lists it was added to by listGenerator.
+         * @param i Index of the generator.
+         */
+        void unlistGenerator(uint i);
+
+        /**
+         * Switch a generator to the form matching its support.
+         * @param i Index of the generator.
+         */
+        void adaptForm(uint i);
+
+        /**
+         * Convert a sparse generator to the dense form.
+         * @param i Index of the generator.
+         */
+        void makeDense(uint i);
+
+        /**
+         * Call visit(j, pauli) for every qubit j on which the generator acts non-trivially, in increasing order.
+         * @param generator The generator.
+         * @param visit Function to call.
+         */
+        template<class Visit>
+        void forEachPauli(const Generator &generator, Visit visit) const;
+
+        /**
+         * Set a generator to the identity with phase bit 0.
+         * @param i Index of the generator.
+         */
+        void clearGenerator(uint i);
+
+        /**
+         * Set a generator equal to another one.
+         * @param destination Index of the generator to overwrite.
+         * @param source Index of the generator to copy.
+         */
+        void copyGenerator(uint destination, uint source);
+
+        /**
+         * Call visit(i, generator, pauli) for every generator i among 1 to 2n acting non-trivially on a qubit.
+         * The visit must not change which generators act on the qubit.
+         * @param j Index of the qubit.
+         * @param visit Function to call.
+         */
+        template<class Visit>
+        void forEachGeneratorOn(uint j, Visit visit);
+
+        /**
+         * Collect the generators listed for a qubit whose Pauli on the qubit satisfies a condition into affected.
+         * @param j Index of the qubit.
+         * @param condition Predicate on the bits (x << 1) | z of the Pauli.
+         */
+        template<class Condition>
+        void collectAffected(uint j, Condition condition);
+
+        /**
+         * Check the indices of a generator and a qubit for get_x, set_x, get_z and set_z.
+         * @param i Index of the generator.
+         * @param j Index of the qubit.
+         * @param message Message of the invalid argument exception.
+         */
+        void check_indices(uint i, uint j, const std::string &message) const;
+
+    protected:
+        /**
+         * The algorithm uses a subroutine called rowsum (h, i), which sets generator h equal to i + h.
+         * Sparse generators are merged along their sorted qubits, a dense generator h visits only the support of i
+         * unless both are dense, in which case the packed kernels of the improved tableau are used.
+         * @param h The generator to update.
+         * @param i The generator to add to h.
+         */
+        void rowsum(uint h, uint i);
+
+    public:
+        /**
+         * Construct a new SparseStabilizerTableau object.
+         */
+        SparseStabilizerTableau() = default;
+
+        /**
+         * Initialize the tableau to the state |0〉^(⊗n), in which every generator acts on a single qubit.
+         * @param p_n Number of qubits in the system.
+         */
+        void initializeTableau(uint p_n) override;
+
+        /// Superclass overrides begin.
+        void CNOT(uint control, uint target) override;
+
+        void Hadamard(uint qubit) override;
+
+        void Phase(uint qubit) override;
+
+        uint8_t Measurement(uint qubit) override;
+
+        void PauliX(uint qubit) override;
+
+        void PauliY(uint qubit) override;
+
+        void PauliZ(uint qubit) override;
+
+        void SWAP(uint qubit1, uint qubit2) override;
+
+        void Clifford(uint qubit, const SingleQubitClifford &clifford) override;
+
+        /**
+         * The snapshot lists the non-trivial Paulis of all generators, so its size scales with their support.
+         * @param snapshot Snapshot to overwrite.
+         */
+        void saveSnapshot(TableauSnapshot &snapshot) const override;
+
+        void restoreSnapshot(const TableauSnapshot &snapshot) override;
+
+        bool hasRandomOutcome(uint qubit) override;
+
+        /**
+         * Expands the stabilizers into dense rows, which are reduced like those of the improved tableau.
+         * @return The distribution of the outcomes of all qubits.
+         */
+        OutcomeSpace outcomeSpace() override;
+        /// Superclass overrides end.
+
+        /**
+         * Get the number of qubits on which a generator acts non-trivially.
+         * @param i Index of the generator.
+         * @return The support size of the generator.
+         */
+        uint support(uint i) const;
+
+        /**
+         * Set the value of the x operator bit for a qubit.
+         * @param i Index of the generator.
+         * @param j Index of qubit.
+         * @param x Value of the x operator bit.
+         */
+        void set_x(uint i, uint j, uint8_t x);
+
+        /**
+         * Set the value of the z operator bit for a qubit.
+         * @param i Index of the generator.
+         * @param j Index of qubit.
+         * @param z Value of the z operator bit.
+         */
+        void set_z(uint i, uint j, uint8_t z);
+
+        /**
+         * Set the value of the phase operator bit for a qubit.
+         * @param i Index of the generator.
+         * @param r Value of the phase operator bit.
+         */
+        void set_r(uint i, uint8_t r);
+
+        /**
+         * Get the value of the x operator bit for a qubit.
+         * @param i Index of the generator.
+         * @param j Index of qubit.
+         */
+        uint8_t get_x(uint i, uint j);
+
+        /**
+         * Get the value of the z operator bit for a qubit.
+         * @param i Index of the generator.
+         * @param j Index of qubit.
+         */
+        uint8_t get_z(uint i, uint j);
+
+        /**
+         * Get the value of the phase operator bit for a generator.
+         * @param i Index of the generator.
+         */
+        uint8_t get_r(uint i);
+    };
+}
@@ -1,55 +1,56 @@
 
 #include "stabilizer_circuit.h"
+#include "compiled_circuit.h"
+#include "qasm_reader.h"
+#include "binary_circuit.h"
+#include "instrumentation.h"
+
+#include <stdexcept>
 
 
 namespace CliffordTableaus {
     std::string StabilizerCircuit::executeCircuit(const std::string &circuit_filename, StabilizerTableau &tableau) {
-        auto file = retrieveCircuitFile(circuit_filename);
-
-        std::string line;
-        if (!std::getline(file, line) || line != "OPENQASM 3;") {
-            std::cerr << "Invalid QASM format: missing 'OPENQASM 3;' on the first line." << std::endl;
-            return "";
+        auto circuit_path = circuitFilePath(circuit_filename);
+        if (BinaryCircuit::isBinaryCircuit(circuit_path)) {
+            return CompiledCircuit::load(circuit_filename).run(tableau);
         }
 
-        // Read the second line (qreg q[n];) and parse the number of qubits
-        if (!std::getline(file, line)) {
-            std::cerr << "Invalid QASM format: missing 'qreg q[n];' on the second line." << std::endl;
+        // Stream the circuit through the tableau chunk by chunk, the instructions are never held in memory all at once.
+        QasmReader reader(circuit_path);
+        uint n;
+        if (!reader.readHeader(n)) {
             return "";
         }
-
-        std::smatch match;
-        if (line == "include \"stdgates.inc\";") {
-            if (!std::getline(file, line)) {
-                std::cerr << "Invalid QASM format: missing 'qreg q[n];' after include statement." << std::endl;
-                return "";
-            }
-        }
-
-        if (!std::regex_match(line, match, qreg_regex)) {
-            std::cerr << "Invalid QASM format: 'qreg q[n];' expected on the second line." << std::endl;
-            return "";
-        }
-
-        auto n = std::stoul(match[1]);
         tableau.initializeTableau(n);
         std::string measurement_result(n, 'x');
-
-        while (std::getline(file, line)) {
-            if (line.empty()) {
-                continue;
-            }
-            if (!applyGateLine(line, tableau, measurement_result)) {
-                std::cerr << "Warning: " << line << " is not a valid QASM3 line." << std::endl;
+        std::vector<Instruction> chunk;
+        while (reader.readChunk(chunk) > 0) {
+            for (const auto &instruction: chunk) {
+                applyInstruction(instruction, tableau, measurement_result);
             }
         }
         return measurement_result;
     }
 
+    bool StabilizerCircuit::compileCircuit(
+            const std::string &circuit_filename, uint &n_qubits, std::vector<Instruction> &instructions
+    ) {
+        TABLEAU_STATS_PHASE(timer, STATS_PARSE, 1);
+        QasmReader reader(circuitFilePath(circuit_filename));
+        if (!reader.readHeader(n_qubits)) {
+            return false;
+        }
+
+        instructions.clear();
+        std::vector<Instruction> chunk;
+        while (reader.readChunk(chunk) > 0) {
+            instructions.insert(instructions.end(), chunk.begin(), chunk.end());
+        }
+        return true;
+    }
 
     std::string StabilizerCircuit::interactiveMode(StabilizerTableau &tableau) {
         uint n = 0;
-        std::smatch match;
         while (true) {
             std::cout << "Initialize the number of qubit register in QASM3 format: qreg q[n];\n> ";
             std::string line;
@@ -59,8 +60,7 @@ namespace CliffordTableaus {
             }
             trimLine(line);
 
-            if (std::regex_match(line, match, qreg_regex)) {
-                n = std::stoul(match[1]);
+            if (QasmReader::parseQregLine(line, n)) {
                 break;
             } else {
                 std::cout << "Error: Incorrect format. Expected format: qreg q[n];" << std::endl;
@@ -91,10 +91,11 @@ namespace CliffordTableaus {
                 break;
             }
             if (line == "finish" || line == "measure all") {
+                // Qubits measured before keep their outcome, which MeasureAll reproduces.
+                auto outcomes = tableau.MeasureAll();
                 for (uint q_index = 0; q_index < n; ++q_index) {
                     if (measurement_result.at(q_index) == 'x') {
-                        uint8_t measurement = tableau.Measurement(q_index + 1);
-                        measurement_result.at(q_index) = static_cast<char>('0' + measurement);
+                        measurement_result.at(q_index) = static_cast<char>('0' + outcomes[q_index]);
                     }
                 }
                 break;
@@ -110,76 +111,44 @@ namespace CliffordTableaus {
     bool StabilizerCircuit::applyGateLine(
             const std::string &line, StabilizerTableau &tableau, std::string &measurement_result
     ) {
-        std::smatch match;
-        if (std::regex_match(line, match, id_regex)) {
-            uint q_index = std::stoul(match[1]);
-
-            // Measurement result is not affected by the identity gate
-            tableau.Identity(q_index + 1);
-
-            return true;
-        } else if (std::regex_match(line, match, cnot_regex)) {
-            uint control = std::stoul(match[1]);
-            uint target = std::stoul(match[2]);
-
-            tableau.CNOT(control + 1, target + 1);
-            measurement_result.at(control) = 'x';
-            measurement_result.at(target) = 'x';
-
-            return true;
-        } else if (std::regex_match(line, match, h_regex)) {
-            uint q_index = std::stoul(match[1]);
-
-            tableau.Hadamard(q_index + 1);
-            measurement_result.at(q_index) = 'x';
-
-            return true;
-        } else if (std::regex_match(line, match, s_regex)) {
-            uint q_index = std::stoul(match[1]);
-
-            tableau.Phase(q_index + 1);
-            measurement_result.at(q_index) = 'x';
-
-            return true;
-        } else if (std::regex_match(line, match, measure_regex)) {
-            uint q_index = std::stoul(match[1]);
-
-            uint8_t measurement = tableau.Measurement(q_index + 1);
-            measurement_result.at(q_index) = static_cast<char>('0' + measurement);
-
-            return true;
-        } else if (std::regex_match(line, match, x_regex)) {
-            uint q_index = std::stoul(match[1].str());
-
-            tableau.PauliX(q_index + 1);
-            measurement_result.at(q_index) = 'x';
-
-            return true;
-        } else if (std::regex_match(line, match, y_regex)) {
-            uint q_index = std::stoul(match[1].str());
-
-            tableau.PauliY(q_index + 1);
-            measurement_result.at(q_index) = 'x';
-
-            return true;
-        } else if (std::regex_match(line, match, z_regex)) {
-            uint q_index = std::stoul(match[1].str());
-
-            tableau.PauliZ(q_index + 1);
-            measurement_result.at(q_index) = 'x';
+        Instruction instruction{};
+        if (!parseGateLine(line, instruction)) {
+            return false;
+        }
+        applyInstruction(instruction, tableau, measurement_result);
+        return true;
+    }
 
-            return true;
-        } else if (std::regex_match(line, match, swap_regex)) {
-            uint q_index1 = std::stoul(match[1]);
-            uint q_index2 = std::stoul(match[2]);
+    bool StabilizerCircuit::parseGateLine(const std::string &line, Instruction &instruction) {
+        return QasmReader::parseGateLine(line, instruction);
+    }
 
-            tableau.SWAP(q_index1 + 1, q_index2 + 1);
-            measurement_result.at(q_index1) = 'x';
-            measurement_result.at(q_index2) = 'x';
+    void StabilizerCircuit::applyInstruction(
+            const Instruction &instruction, StabilizerTableau &tableau, std::string &measurement_result
+    ) {
+        if (instruction.gate == MEASURE) {
+            uint8_t measurement = tableau.Measurement(instruction.qubit1 + 1);
+            measurement_result.at(instruction.qubit1) = static_cast<char>('0' + measurement);
+            return;
+        }
+        tableau.applyGate(instruction);
+        markUnmeasured(instruction, measurement_result);
+    }
 
-            return true;
-        } else {
-            return false;
+    void StabilizerCircuit::markUnmeasured(const Instruction &instruction, std::string &measurement_result) {
+        switch (instruction.gate) {
+            case IDENTITY:
+            case MEASURE:
+                // Measurement result is not affected by the identity gate
+                break;
+            case CNOT:
+            case SWAP:
+                measurement_result.at(instruction.qubit1) = 'x';
+                measurement_result.at(instruction.qubit2) = 'x';
+                break;
+            default:
+                measurement_result.at(instruction.qubit1) = 'x';
+                break;
         }
     }
 
@@ -192,9 +161,10 @@ namespace CliffordTableaus {
             uint qubit_seed,
             bool allow_intermediate_measurement,
             bool measure_all_at_the_end,
-            bool overwrite_file
+            bool overwrite_file,
+            bool binary_format
     ) {
-        auto file = createCircuitFile(circuit_filename, overwrite_file);
+        auto file = createCircuitFile(circuit_filename, overwrite_file, binary_format);
 
         std::vector<Gate> allowed_gates = {PAULI_X, PAULI_Y, PAULI_Z, HADAMARD, PHASE};
         if (n_qubits >= 2) {
@@ -230,13 +200,28 @@ namespace CliffordTableaus {
         }
         std::uniform_int_distribution<uint> qubit_dist(0, n_qubits - 1);
 
-        file << "OPENQASM 3;\n";
-        file << "qreg q[" << n_qubits << "];\n";
+        if (binary_format) {
+            BinaryCircuit::writeHeader(file, n_qubits);
+        } else {
+            file << "OPENQASM 3;\n";
+            file << "qreg q[" << n_qubits << "];\n";
+        }
         for (int i = 0; i < depth; ++i) {
             uint q1 = qubit_dist(qubit_generator);
             uint q2 = 0;
+            auto gate = allowed_gates[gate_distribution(gate_generator)];
+            if (gate == CNOT || gate == SWAP) {
+                q2 = qubit_dist(qubit_generator);
+                while (q2 == q1) {
+                    q2 = qubit_dist(qubit_generator);
+                }
+            }
+            if (binary_format) {
+                BinaryCircuit::writeInstruction(file, {gate, static_cast<uint32_t>(q1), static_cast<uint32_t>(q2)});
+                continue;
+            }
 
-            switch (allowed_gates[gate_distribution(gate_generator)]) {
+            switch (gate) {
                 case IDENTITY:
                     file << getIdentity(q1);
                     break;
@@ -250,10 +235,6 @@ namespace CliffordTableaus {
                     file << getPauliZ(q1);
                     break;
                 case CNOT:
-                    q2 = qubit_dist(qubit_generator);
-                    while (q2 == q1) {
-                        q2 = qubit_dist(qubit_generator);
-                    }
                     file << getCNOT(q1, q2);
                     break;
                 case HADAMARD:
@@ -266,24 +247,28 @@ namespace CliffordTableaus {
                     file << getMeasurement(q1);
                     break;
                 case SWAP:
-                    q2 = qubit_dist(qubit_generator);
-                    while (q2 == q1) {
-                        q2 = qubit_dist(qubit_generator);
-                    }
                     file << getSWAP(q1, q2);
                     break;
+                case CLIFFORD:
+                    // Fused single-qubit Cliffords only arise from the optimizer, never from the allowed gates.
+                    throw std::logic_error("Random circuits cannot contain fused single-qubit Cliffords.");
             }
         }
 
         if (measure_all_at_the_end) {
             for (uint qubit = 0; qubit < n_qubits; ++qubit) {
-                file << "measure q[" << qubit << "];\n";
+                if (binary_format) {
+                    BinaryCircuit::writeInstruction(file, {MEASURE, static_cast<uint32_t>(qubit), 0});
+                } else {
+                    file << "measure q[" << qubit << "];\n";
+                }
             }
         }
     }
 
 
-    std::ofstream StabilizerCircuit::createCircuitFile(const std::string &circuit_filename, bool overwrite_file) {
+    std::ofstream StabilizerCircuit::createCircuitFile(const std::string &circuit_filename, bool overwrite_file,
+                                                       bool binary_format) {
         // Get the directory of the current source file otherwise execution from different location will throw errors.
         // Ensure the directory exists by creating it if it doesn't.
         // Finally construct the full path to the file.
@@ -297,32 +282,24 @@ namespace CliffordTableaus {
         if (!overwrite_file && fs::exists(file_path)) {
             throw std::invalid_argument("File already exists.");
         }
-        std::ofstream file(file_path);
+        std::ofstream file(file_path, binary_format ? std::ios::out | std::ios::binary : std::ios::out);
         if (!file.is_open()) {
             throw std::runtime_error("Unable to open file for writing.");
         }
         return file;
     }
 
-    std::ifstream StabilizerCircuit::retrieveCircuitFile(const std::string &circuit_filename) {
+    std::filesystem::path StabilizerCircuit::circuitFilePath(const std::string &circuit_filename) {
         // Get the directory of the current source file otherwise execution from different location will throw errors.
-        // Ensure the directory exists by creating it if it doesn't.
         namespace fs = std::filesystem;
         fs::path base_directory = fs::path(__FILE__).parent_path() / "stabilizer_circuits";
-        fs::create_directories(base_directory);
         fs::path file_path = base_directory / circuit_filename;
 
         // Check if the file exists. If it doesn't, throw an error.
         if (!fs::exists(file_path)) {
             throw std::runtime_error("File does not exist: " + file_path.string());
         }
-
-        // Open the file for reading.
-        std::ifstream file(file_path);
-        if (!file.is_open()) {
-            throw std::runtime_error("Unable to open file for reading: " + file_path.string());
-        }
-        return file;
+        return file_path;
     }
 
 
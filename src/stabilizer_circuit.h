@@ -1,15 +1,16 @@
 #pragma once
 
 #include "stabilizer_tableau.h"
+#include "circuit_instruction.h"
 
 #include <iostream>
 #include <cstdint>
 #include <cstdint>
 #include <vector>
+#include <algorithm>
 #include <array>
 #include <fstream>
 #include <sstream>
-#include <regex>
 #include <utility>
 #include <random>
 #include <complex>
@@ -17,33 +18,17 @@
 
 namespace CliffordTableaus {
     using uint = std::size_t;
-    static const std::regex qreg_regex = std::regex(R"(^qreg q\[(\d+)\];$)");
-    static const std::regex id_regex = std::regex(R"(^id q\[(\d+)\];$)");
-    static const std::regex cnot_regex = std::regex(R"(^cx q\[(\d+)\],q\[(\d+)\];$)");
-    static const std::regex h_regex = std::regex(R"(^h q\[(\d+)\];$)");
-    static const std::regex s_regex = std::regex(R"(^s q\[(\d+)\];$)");
-    static const std::regex x_regex = std::regex(R"(^x q\[(\d+)\];$)");
-    static const std::regex y_regex = std::regex(R"(^y q\[(\d+)\];$)");
-    static const std::regex z_regex = std::regex(R"(^z q\[(\d+)\];$)");
-    static const std::regex swap_regex = std::regex(R"(^swap q\[(\d+)\],q\[(\d+)\];$)");
-    static const std::regex measure_regex = std::regex(R"(^measure q\[(\d+)\];$)");
-
     class StabilizerCircuit {
     private:
         /**
          * Create the file containing the circuit.
          * @param circuit_filename File containing the circuit in QASM3 format.
          * @param overwrite_file Whether the file should be overwritten if it already exists.
+         * @param binary_format Whether to open the file in binary mode.
          * @return An output file stream to the circuit file.
          */
-        static std::ofstream createCircuitFile(const std::string &circuit_filename, bool overwrite_file);
-
-        /**
-         * Retrieve the file containing the circuit.
-         * @param circuit_filename File containing the circuit in QASM3 format.
-         * @return A file stream to the circuit file.
-         */
-        static std::ifstream retrieveCircuitFile(const std::string &circuit_filename);
+        static std::ofstream createCircuitFile(const std::string &circuit_filename, bool overwrite_file,
+                                               bool binary_format = false);
 
         /**
          * Apply the operation given by the line, which is expected to be in QASM3 syntax to the tableau.
@@ -56,10 +41,59 @@ namespace CliffordTableaus {
         static bool applyGateLine(const std::string &line, StabilizerTableau &tableau, std::string &measurement_result);
 
     public:
+        /**
+         * Resolve the path of the file containing the circuit.
+         * Throws a runtime error if the file does not exist.
+         * @param circuit_filename File containing the circuit in QASM3 or binary format.
+         * Relative names are resolved within the stabilizer_circuits directory.
+         * @return Path to the circuit file.
+         */
+        static std::filesystem::path circuitFilePath(const std::string &circuit_filename);
+
+        /**
+         * Parse a line in QASM3 syntax into an instruction.
+         * @param line Line in QASM3 syntax which describes the operation to perform.
+         * @param instruction Instruction to write the parsed operation to.
+         * @return Whether the line is a valid operation.
+         */
+        static bool parseGateLine(const std::string &line, Instruction &instruction);
+
+        /**
+         * Apply a compiled instruction to the tableau.
+         * In case the operation has an effect on the measurement results, update the measurement result string.
+         * @param instruction Instruction to apply.
+         * @param tableau Utilized Tableau to apply the operation to.
+         * @param measurement_result String with running measurement results.
+         */
+        static void applyInstruction(
+                const Instruction &instruction, StabilizerTableau &tableau, std::string &measurement_result
+        );
+
+        /**
+         * Mark the qubits acted upon by a unitary instruction as unmeasured with 'x' in the measurement result string.
+         * The identity gate leaves the measurement result unaffected.
+         * @param instruction Instruction which has been applied.
+         * @param measurement_result String with running measurement results.
+         */
+        static void markUnmeasured(const Instruction &instruction, std::string &measurement_result);
+
+        /**
+         * Parse the stabilizer circuit given by the QASM3 code in the file given by circuit_filename once
+         * into a compact list of instructions, which can then be executed any number of times.
+         * Invalid lines are reported once and skipped.
+         * The file is read with a QasmReader, so only the instructions themselves occupy memory.
+         * @param circuit_filename File containing the circuit in QASM3 format.
+         * @param n_qubits Number of qubits declared by the circuit.
+         * @param instructions The instructions of the circuit in order of execution.
+         * @return Whether the file has a valid QASM3 header.
+         */
+        static bool compileCircuit(
+                const std::string &circuit_filename, uint &n_qubits, std::vector<Instruction> &instructions
+        );
 
         /**
          * Execute a stabilizer circuit given by the QASM3 code in the file given by circuit_filename
-         * using the provided stabilizer tableau.
+         * using the provided stabilizer tableau. Circuits in the binary format of BinaryCircuit are detected and loaded too.
          * If qubits are measured without further operations, the returned string will contain the measurement results.
          * In place of all unmeasured qubits, the return string will contain 'x'.
          * @param circuit_filename File containing the circuit in QASM3 format.
@@ -91,6 +125,7 @@ namespace CliffordTableaus {
          * @param allow_intermediate_measurement Whether the circuit measures qubits intermediately during execution.
          * @param measure_all_at_the_end Whether the circuit should measure all qubits at the end.
          * @param overwrite_file Whether the file should be overwritten if it already exists.
+         * @param binary_format Whether to write the circuit in the binary format of BinaryCircuit instead of QASM3.
          */
         static void createRandomStabilizerCircuit(
                 const std::string &circuit_filename,
@@ -100,7 +135,8 @@ namespace CliffordTableaus {
                 uint qubit_seed = 0,
                 bool allow_intermediate_measurement = false,
                 bool measure_all_at_the_end = true,
-                bool overwrite_file = false
+                bool overwrite_file = false,
+                bool binary_format = false
         );
 
         /**
@@ -184,19 +220,4 @@ namespace CliffordTableaus {
             return !std::isspace(c);
         }).base(), line.end());
     }
-
-    /**
-     * Supported gates in the stabilizer circuit.
-     */
-    enum Gate {
-        IDENTITY,
-        PAULI_X,
-        PAULI_Y,
-        PAULI_Z,
-        CNOT,
-        HADAMARD,
-        PHASE,
-        MEASURE,
-        SWAP
-    };
-}
\ No newline at end of file
+}
@@ -1,10 +1,186 @@
 #include "stabilizer_tableau.h"
+#include "improved_simulation_of_stabilizer_circuits/subroutines.h"
+#include "stim_a_fast_stabilizer_circuit_simulator/simd_kernels.h"
+
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+#include <utility>
 
 namespace CliffordTableaus {
     void StabilizerTableau::initializeTableau(uint p_n, uint p_total_bits) {
         this->n = p_n;
         this->total_bits = p_total_bits;
-        this->tableau = std::vector<uint8_t>((total_bits + 7) / 8, 0);
+        // Unlike a freshly allocated vector, assign keeps the capacity, so repeated shots only clear the words.
+        this->tableau.assign((total_bits + 63) / 64, 0);
+    }
+
+    void StabilizerTableau::setRng(Rng *p_rng) {
+        rng = p_rng;
+    }
+
+    void StabilizerTableau::saveSnapshot(TableauSnapshot &snapshot) const {
+        snapshot.n = n;
+        snapshot.total_bits = total_bits;
+        snapshot.words.assign(tableau.begin(), tableau.end());
+    }
+
+    void StabilizerTableau::restoreSnapshot(const TableauSnapshot &snapshot) {
+        n = snapshot.n;
+        total_bits = snapshot.total_bits;
+        // Reuses the storage of the tableau if it already has the right size, which makes this a single memcpy.
+        tableau.assign(snapshot.words.begin(), snapshot.words.end());
+    }
+
+    uint StabilizerTableau::reduceStabilizers(std::vector<uint64_t> &stabilizers, uint qubit_words,
+                                              std::vector<uint> &pivot_qubits) {
+        auto row_words = 2 * qubit_words + 1;
+        auto row = [&](uint i) {
+            return stabilizers.data() + i * row_words;
+        };
+        auto bit = [](const uint64_t *words, uint j) {
+            return (words[j / 64] >> (j % 64)) & 1;
+        };
+        auto &kernels = simd_kernels();
+
+        // First, eliminate the x bits qubit by qubit with the rowsum of the improved algorithm.
+        // Afterwards the stabilizers rank to n - 1 are products of Z only.
+        uint rank = 0;
+        for (uint j = 0; j < n && rank < n; ++j) {
+            uint pivot = rank;
+            while (pivot < n && bit(row(pivot), j) == 0) {
+                ++pivot;
+            }
+            if (pivot == n) {
+                continue;
+            }
+            std::swap_ranges(row(pivot), row(pivot) + row_words, row(rank));
+            auto source = row(rank);
+            for (uint h = rank + 1; h < n; ++h) {
+                auto target = row(h);
+                if (bit(target, j) == 0) {
+                    continue;
+                }
+                int sum_g = 2 * static_cast<int>(target[2 * qubit_words] + source[2 * qubit_words]) +
+                            kernels.g_packed(source, source + qubit_words, target, target + qubit_words, qubit_words);
+                sum_g = ((sum_g % 4) + 4) % 4;
+                if (sum_g == 1 || sum_g == 3) {
+                    throw std::logic_error("Sum_g should never be congruent to 1 or 3.");
+                }
+                target[2 * qubit_words] = sum_g / 2;
+                kernels.xor_words(target, source, 2 * qubit_words);
+            }
+            ++rank;
+        }
+
+        // Second, bring the products of Z into reduced row echelon form.
+        // Products of Z commute and square to the identity, so their phase bits simply add up,
+        // and the z words and the phase word, which are adjacent, are XORed in one pass.
+        pivot_qubits.clear();
+        auto z_rank = rank;
+        for (uint j = 0; j < n && z_rank < n; ++j) {
+            uint pivot = z_rank;
+            while (pivot < n && bit(row(pivot) + qubit_words, j) == 0) {
+                ++pivot;
+            }
+            if (pivot == n) {
+                continue;
+            }
+            std::swap_ranges(row(pivot), row(pivot) + row_words, row(z_rank));
+            auto source = row(z_rank) + qubit_words;
+            for (uint h = rank; h < n; ++h) {
+                if (h != z_rank && bit(row(h) + qubit_words, j) == 1) {
+                    kernels.xor_words(row(h) + qubit_words, source, qubit_words + 1);
+                }
+            }
+            pivot_qubits.push_back(j);
+            ++z_rank;
+        }
+        return rank;
+    }
+
+    std::vector<uint8_t> StabilizerTableau::sampleMeasureAll(std::vector<uint64_t> &stabilizers, uint qubit_words) {
+        auto row_words = 2 * qubit_words + 1;
+        std::vector<uint> pivot_qubits;
+        auto rank = reduceStabilizers(stabilizers, qubit_words, pivot_qubits);
+        auto row = [&](uint i) {
+            return stabilizers.data() + i * row_words;
+        };
+
+        // The qubits without a pivot are random. Each pivot qubit is the only pivot qubit of its row,
+        // so its outcome is the phase bit plus the outcomes of the random qubits of the row.
+        std::vector<uint64_t> random_outcomes(qubit_words, 0);
+        std::vector<uint8_t> outcomes(n, 0);
+        std::vector<bool> is_pivot(n, false);
+        for (auto j: pivot_qubits) {
+            is_pivot[j] = true;
+        }
+        for (uint j = 0; j < n; ++j) {
+            if (!is_pivot[j]) {
+                outcomes[j] = randomBit();
+                random_outcomes[j / 64] |= static_cast<uint64_t>(outcomes[j]) << (j % 64);
+            }
+        }
+        for (uint t = 0; t < pivot_qubits.size(); ++t) {
+            auto z = row(rank + t) + qubit_words;
+            uint64_t parity = z[qubit_words];
+            for (uint w = 0; w < qubit_words; ++w) {
+                parity ^= std::popcount(z[w] & random_outcomes[w]);
+            }
+            outcomes[pivot_qubits[t]] = parity & 1;
+        }
+        return outcomes;
+    }
+
+    OutcomeSpace StabilizerTableau::reduceOutcomeSpace(std::vector<uint64_t> &stabilizers, uint qubit_words) {
+        auto row_words = 2 * qubit_words + 1;
+        std::vector<uint> pivot_qubits;
+        auto rank = reduceStabilizers(stabilizers, qubit_words, pivot_qubits);
+        auto row = [&](uint i) {
+            return stabilizers.data() + i * row_words;
+        };
+        auto bit = [](const uint64_t *words, uint j) {
+            return (words[j / 64] >> (j % 64)) & 1;
+        };
+
+        // Setting all random qubits to 0 leaves the phase bits as the outcomes of the pivot qubits.
+        // Setting a single random qubit to 1 additionally flips the pivot qubits of the rows containing it.
+        std::vector<uint64_t> offset(qubit_words, 0);
+        std::vector<uint64_t> basis;
+        std::vector<bool> is_pivot(n, false);
+        for (uint t = 0; t < pivot_qubits.size(); ++t) {
+            is_pivot[pivot_qubits[t]] = true;
+            auto z = row(rank + t) + qubit_words;
+            offset[pivot_qubits[t] / 64] |= (z[qubit_words] & 1) << (pivot_qubits[t] % 64);
+        }
+        for (uint j = 0; j < n; ++j) {
+            if (is_pivot[j]) {
+                continue;
+            }
+            auto vector = basis.insert(basis.end(), qubit_words, 0);
+            vector[j / 64] |= uint64_t{1} << (j % 64);
+            for (uint t = 0; t < pivot_qubits.size(); ++t) {
+                auto z = row(rank + t) + qubit_words;
+                vector[pivot_qubits[t] / 64] |= bit(z, j) << (pivot_qubits[t] % 64);
+            }
+        }
+        return {n, std::move(offset), std::move(basis)};
+    }
+
+    OutcomeSpace StabilizerTableau::outcomeSpace() {
+        throw std::runtime_error("This stabilizer tableau does not support computing the exact outcome distribution.");
+    }
+
+    std::vector<uint8_t> StabilizerTableau::MeasureAll() {
+        std::vector<uint8_t> outcomes(n);
+        for (uint qubit = 1; qubit <= n; ++qubit) {
+            outcomes[qubit - 1] = Measurement(qubit);
+        }
+        return outcomes;
+    }
+
+    uint8_t StabilizerTableau::randomBit() {
+        return rng != nullptr ? rng->random_bit() : random_bit();
     }
 
     void StabilizerTableau::Identity(uint qubit) const {
@@ -85,4 +261,60 @@ namespace CliffordTableaus {
         this->CNOT(qubit2, qubit1);
         this->CNOT(qubit1, qubit2);
     }
-}
\ No newline at end of file
+
+    void StabilizerTableau::Clifford(uint qubit, const SingleQubitClifford &clifford) {
+        if (qubit == 0) {
+            std::cerr << "Warning: Attempted to apply Clifford with qubit = 0!" << std::endl;
+            return;
+        }
+        if (qubit > n) {
+            std::cerr << "Warning: Attempted to apply Clifford with qubit > n!" << std::endl;
+            return;
+        }
+        for (auto gate: clifford.decomposition()) {
+            applyGate({gate, static_cast<uint32_t>(qubit - 1), 0});
+        }
+    }
+
+    void StabilizerTableau::applyGate(const Instruction &instruction) {
+        uint q_index1 = instruction.qubit1;
+        uint q_index2 = instruction.qubit2;
+        switch (instruction.gate) {
+            case IDENTITY:
+                Identity(q_index1 + 1);
+                break;
+            case PAULI_X:
+                PauliX(q_index1 + 1);
+                break;
+            case PAULI_Y:
+                PauliY(q_index1 + 1);
+                break;
+            case PAULI_Z:
+                PauliZ(q_index1 + 1);
+                break;
+            case Gate::CNOT:
+                CNOT(q_index1 + 1, q_index2 + 1);
+                break;
+            case HADAMARD:
+                Hadamard(q_index1 + 1);
+                break;
+            case PHASE:
+                Phase(q_index1 + 1);
+                break;
+            case Gate::SWAP:
+                SWAP(q_index1 + 1, q_index2 + 1);
+                break;
+            case CLIFFORD:
+                Clifford(q_index1 + 1, SingleQubitClifford::fromInstruction(instruction));
+                break;
+            case MEASURE:
+                throw std::invalid_argument("Measurements cannot be applied as a gate.");
+        }
+    }
+
+    void StabilizerTableau::applyLayer(std::span<const Instruction> layer) {
+        for (const auto &instruction: layer) {
+            applyGate(instruction);
+        }
+    }
+}
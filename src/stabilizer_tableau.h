@@ -1,7 +1,13 @@
 #pragma once
 
+#include "aligned_allocator.h"
+#include "circuit_instruction.h"
+#include "outcome_space.h"
+#include "single_qubit_clifford.h"
+
 #include <cstdint>
 #include <cstdint>
+#include <span>
 #include <vector>
 #include <iostream>
 
@@ -9,6 +15,29 @@
 namespace CliffordTableaus {
     using uint = std::size_t;
 
+    class Rng;
+
+    /**
+     * Copy of the complete state of a stabilizer tableau, taken with StabilizerTableau::saveSnapshot.
+     * A snapshot can only be restored into a tableau of the same type as the one it was taken from.
+     */
+    struct TableauSnapshot {
+        /**
+         * The number of qubits in the system.
+         */
+        uint n{};
+
+        /**
+         * The total number of bits in the tableau.
+         */
+        uint total_bits{};
+
+        /**
+         * The words of the tableau in the layout of the tableau type.
+         */
+        std::vector<uint64_t> words;
+    };
+
     class StabilizerTableau {
     protected:
         /**
@@ -28,8 +57,20 @@ namespace CliffordTableaus {
          * The stabilizer generators occupy the next n rows.
          * It is convenient to add an additional (2n+1)-st row for scratch space.
          * Therefore the tableau is (2n+1)x(2n+1) big.
+         * The bits are packed into 64-bit words, the layout of the words is up to the subclass.
          */
-        std::vector<uint8_t> tableau;
+        TableauWords tableau;
+
+        /**
+         * Source of the random measurement outcomes. If not set, the global generator is used.
+         */
+        Rng *rng = nullptr;
+
+        /**
+         * Generate a random measurement outcome, either 0 or 1 with equal probability.
+         * @return Random bit, either 0 or 1.
+         */
+        uint8_t randomBit();
 
         /**
          * Default Constructor exclusively for the subclasses.
@@ -38,11 +79,45 @@ namespace CliffordTableaus {
 
         /**
         * Initialize the tableau with the given number of qubits and total bits.
+        * All words are set to 0, reusing the storage of the previous state if it is large enough.
         * @param p_n Number of qubits in the system.
         * @param p_total_bits Number of bits necessary to specify the state using the tableau.
         */
         void initializeTableau(uint p_n, uint p_total_bits);
 
+        /**
+         * Reduce the stabilizer generators for measuring all qubits.
+         * First the x bits of the stabilizers are eliminated with rowsum, which leaves the stabilizers
+         * that are products of Z only, each fixing the parity of the outcomes of its qubits to its phase bit.
+         * These are brought into reduced row echelon form, the outcomes of the qubits without a pivot are random
+         * and determine the outcomes of the pivot qubits.
+         * Both eliminations process 64 qubits per word operation, which takes O(n^3/64) in total.
+         * @param stabilizers The n stabilizer generators, each given by qubit_words x words, qubit_words z words
+         * and a word holding the phase bit. They are overwritten.
+         * @param qubit_words The number of x (or z) words per stabilizer generator.
+         * @param pivot_qubits Set to the 0-based pivot qubits, that of the t-th product of Z at index t.
+         * @return The number of stabilizers containing an X or Y, which precede the products of Z.
+         */
+        uint reduceStabilizers(std::vector<uint64_t> &stabilizers, uint qubit_words, std::vector<uint> &pivot_qubits);
+
+        /**
+         * Sample the outcomes of measuring all qubits from the stabilizer generators alone, for use by MeasureAll.
+         * The random qubits of reduceStabilizers are sampled, the pivot qubits follow from them.
+         * @param stabilizers The stabilizer generators as for reduceStabilizers. They are overwritten.
+         * @param qubit_words The number of x (or z) words per stabilizer generator.
+         * @return The outcome of every qubit, qubit j at index j - 1.
+         */
+        std::vector<uint8_t> sampleMeasureAll(std::vector<uint64_t> &stabilizers, uint qubit_words);
+
+        /**
+         * Compute the distribution of measuring all qubits from the stabilizer generators alone, for use by
+         * outcomeSpace. Every random qubit of reduceStabilizers contributes one basis vector.
+         * @param stabilizers The stabilizer generators as for reduceStabilizers. They are overwritten.
+         * @param qubit_words The number of x (or z) words per stabilizer generator.
+         * @return The exact distribution of the outcomes.
+         */
+        OutcomeSpace reduceOutcomeSpace(std::vector<uint64_t> &stabilizers, uint qubit_words);
+
     public:
         /**
          * Initialize the tableau with the given number of qubits.
@@ -57,6 +132,36 @@ namespace CliffordTableaus {
          */
         virtual ~StabilizerTableau() = default;
 
+        /**
+         * Draw all subsequent random measurement outcomes from the given generator.
+         * @param p_rng Generator to use, which must outlive its use by the tableau. Nullptr for the global generator.
+         */
+        void setRng(Rng *p_rng);
+
+        /**
+         * Copy the current state of the tableau into the snapshot, reusing the storage of the snapshot.
+         * The random number generator is not part of the snapshot.
+         * @param snapshot Snapshot to overwrite.
+         */
+        virtual void saveSnapshot(TableauSnapshot &snapshot) const;
+
+        /**
+         * Restore a state previously saved with saveSnapshot by a tableau of the same type.
+         * This is a plain copy of the words, which is much cheaper than replaying the gates that led to the state.
+         * Subclasses must recompute their layout from the restored number of qubits.
+         * @param snapshot Snapshot to restore.
+         */
+        virtual void restoreSnapshot(const TableauSnapshot &snapshot);
+
+        /**
+         * Check whether measuring the qubit in the current state has a random outcome,
+         * i.e. whether there exists a stabilizer generator p with xpa = 1.
+         * The tableau is not modified.
+         * @param qubit Qubit to measure.
+         * @return True if the outcome is random, false if it is determinate.
+         */
+        virtual bool hasRandomOutcome(uint qubit) = 0;
+
         /**
          * Transform the tableau according to the CNOT gate applied to qubits control and target.
          * After application the tableau stabilizes the state |ψ〉→ CNOT(control, target)|ψ〉.
@@ -86,6 +191,24 @@ namespace CliffordTableaus {
          */
         virtual uint8_t Measurement(uint qubit) = 0;
 
+        /**
+         * Measure all qubits in the standard basis at once, yielding the same distribution of outcomes
+         * as measuring them one after the other. Afterwards the tableau holds the measured basis state.
+         * By default the qubits are measured one after the other.
+         * Subclasses may override this with sampleMeasureAll, which reduces the stabilizers only once.
+         * @return The outcome of every qubit, qubit j at index j - 1.
+         */
+        virtual std::vector<uint8_t> MeasureAll();
+
+        /**
+         * Compute the exact distribution of the outcomes of measuring all qubits in the standard basis,
+         * without measuring them. The state of the tableau is not modified.
+         * Subclasses override this with reduceOutcomeSpace on a copy of their stabilizers.
+         * By default throws a runtime error, since the layout of the words is up to the subclass.
+         * @return The distribution of the outcomes, an affine subspace of the outcomes of the qubits.
+         */
+        virtual OutcomeSpace outcomeSpace();
+
         /**
          * Apply the Identity gate to the qubit.
          * @param qubit Qubit to apply the Identity gate to.
@@ -94,27 +217,56 @@ namespace CliffordTableaus {
 
         /**
          * Apply the Pauli X gate to the qubit via decomposition of X using Hadamard and Phase gates.
+         * Subclasses may override this with the native rule ri ^= zia.
          * @param qubit Qubit to apply the Pauli-X gate to.
          */
-        void PauliX(uint qubit);
+        virtual void PauliX(uint qubit);
 
         /**
          * Apply the Pauli Y gate to the qubit via decomposition of Y using Hadamard and Phase gates.
+         * Subclasses may override this with the native rule ri ^= xia ^ zia.
          * @param qubit Qubit to apply the Pauli-Y gate to.
          */
-        void PauliY(uint qubit);
+        virtual void PauliY(uint qubit);
 
         /**
          * Apply the Pauli Z gate to the qubit via decomposition of Z using Phase gates.
+         * Subclasses may override this with the native rule ri ^= xia.
          * @param qubit Qubit to apply the Pauli-Z gate to.
          */
-        void PauliZ(uint qubit);
+        virtual void PauliZ(uint qubit);
 
         /**
-         * Apply the SWAP gate to the qubits qubit1 and qubit2.
+         * Apply the SWAP gate to the qubits qubit1 and qubit2 via decomposition into three CNOT gates.
+         * Subclasses may override this by exchanging the x and z bits of both qubits.
          * @param qubit1 Qubit to swap with qubit2.
          * @param qubit2 Qubit to swap with qubit1.
          */
-        void SWAP(uint qubit1, uint qubit2);
+        virtual void SWAP(uint qubit1, uint qubit2);
+
+        /**
+         * Apply an arbitrary single-qubit Clifford gate to the qubit via its decomposition into Hadamard, Phase
+         * and Pauli gates.
+         * Subclasses may override this with the native rule ri ^= sign, (xia, zia) = image of (xia, zia).
+         * @param qubit Qubit to apply the gate to.
+         * @param clifford The gate to apply.
+         */
+        virtual void Clifford(uint qubit, const SingleQubitClifford &clifford);
+
+        /**
+         * Apply the unitary gate of a compiled instruction, whose qubit operands are 0-based.
+         * Throws an invalid argument exception for MEASURE, whose outcome would be lost.
+         * @param instruction Instruction to apply.
+         */
+        void applyGate(const Instruction &instruction);
+
+        /**
+         * Apply a layer of unitary gates, typically one moment of gates acting on disjoint qubits.
+         * The gates are applied in order, by default one after the other.
+         * Subclasses may override this to apply the whole layer in a single pass over the tableau.
+         * Throws an invalid argument exception if the layer contains a MEASURE.
+         * @param layer Instructions of the layer with 0-based qubit operands.
+         */
+        virtual void applyLayer(std::span<const Instruction> layer);
     };
 }
\ No newline at end of file
@@ -0,0 +1,157 @@
+#include "frame_simulator.h"
+#include "single_qubit_clifford.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace CliffordTableaus {
+    FrameSimulator::FrameSimulator(const CompiledCircuit &p_circuit, std::string p_reference_sample,
+                                   uint p_batch_words)
+            : circuit(p_circuit), reference_sample(std::move(p_reference_sample)), batch_words(p_batch_words) {
+        auto n = circuit.qubits();
+        for (uint q = 0; q < n; ++q) {
+            if (reference_sample[q] != 'x') {
+                measured_qubits.push_back(q);
+            }
+        }
+        x_frames.resize(n * batch_words);
+        z_frames.resize(n * batch_words);
+        flips.resize(n * batch_words);
+    }
+
+    uint FrameSimulator::batchSize() const {
+        return 64 * batch_words;
+    }
+
+    template<class Randomize>
+    void FrameSimulator::propagate(uint words, Randomize randomize) {
+        auto n = circuit.qubits();
+        auto x = [&](uint q) { return x_frames.data() + q * batch_words; };
+        auto z = [&](uint q) { return z_frames.data() + q * batch_words; };
+
+        // The initial state |0〉^⊗n is stabilized by every Z, so a random Z frame does not change the state.
+        // Randomizing it makes the frames sample the outcomes of measurements which do not commute with Z.
+        for (uint q = 0; q < n; ++q) {
+            std::fill(x(q), x(q) + words, 0);
+            randomize(z(q));
+        }
+
+        for (const auto &instruction: circuit.getProgram()) {
+            uint a = instruction.qubit1;
+            uint b = instruction.qubit2;
+            // Invalid gates are skipped by the tableau as well, invalid measurements throw in the reference shot.
+            if (a >= n) {
+                continue;
+            }
+            switch (instruction.gate) {
+                case IDENTITY:
+                case PAULI_X:
+                case PAULI_Y:
+                case PAULI_Z:
+                    // Pauli gates only change signs, which are already accounted for by the reference shot.
+                    break;
+                case HADAMARD:
+                    std::swap_ranges(x(a), x(a) + words, z(a));
+                    break;
+                case PHASE:
+                    for (uint w = 0; w < words; ++w) {
+                        z(a)[w] ^= x(a)[w];
+                    }
+                    break;
+                case CNOT:
+                    if (b >= n || a == b) {
+                        break;
+                    }
+                    for (uint w = 0; w < words; ++w) {
+                        x(b)[w] ^= x(a)[w];
+                        z(a)[w] ^= z(b)[w];
+                    }
+                    break;
+                case SWAP:
+                    if (b >= n || a == b) {
+                        break;
+                    }
+                    std::swap_ranges(x(a), x(a) + words, x(b));
+                    std::swap_ranges(z(a), z(a) + words, z(b));
+                    break;
+                case CLIFFORD: {
+                    // Map the Pauli of every frame on the qubit to its image, the sign does not matter for a frame.
+                    auto clifford = SingleQubitClifford::fromInstruction(instruction);
+                    auto spread = [&](uint8_t pauli, unsigned int bit) {
+                        return uint64_t{0} - ((clifford.image[pauli] >> bit) & 1u);
+                    };
+                    for (uint w = 0; w < words; ++w) {
+                        auto is_z = ~x(a)[w] & z(a)[w];
+                        auto is_x = x(a)[w] & ~z(a)[w];
+                        auto is_y = x(a)[w] & z(a)[w];
+                        x(a)[w] = (is_z & spread(0b01, 1)) | (is_x & spread(0b10, 1)) | (is_y & spread(0b11, 1));
+                        z(a)[w] = (is_z & spread(0b01, 0)) | (is_x & spread(0b10, 0)) | (is_y & spread(0b11, 0));
+                    }
+                    break;
+                }
+                case MEASURE:
+                    // An X component anticommutes with the measured Z and flips the outcome.
+                    // Afterwards the qubit is a Z eigenstate again, so its Z component is re-randomized.
+                    std::copy(x(a), x(a) + words, flips.data() + a * batch_words);
+                    randomize(z(a));
+                    break;
+            }
+        }
+    }
+
+    void FrameSimulator::sampleBatch(uint shots, Rng &rng, std::unordered_map<std::string, unsigned int> &histogram) {
+        auto words = (shots + 63) / 64;
+        propagate(words, [&](uint64_t *z) {
+            for (uint w = 0; w < words; ++w) {
+                z[w] = rng.random_word();
+            }
+        });
+
+        std::string measurement_result = reference_sample;
+        for (uint shot = 0; shot < shots; ++shot) {
+            for (auto q: measured_qubits) {
+                auto flip = (flips[q * batch_words + shot / 64] >> (shot % 64)) & 1;
+                measurement_result[q] = static_cast<char>(reference_sample[q] ^ flip);
+            }
+            ++histogram[measurement_result];
+        }
+    }
+
+    OutcomeSpace FrameSimulator::outcomeSpace() {
+        auto n = circuit.qubits();
+        const auto &program = circuit.getProgram();
+        uint components = n;
+        for (const auto &instruction: program) {
+            components += instruction.gate == MEASURE && instruction.qubit1 < n;
+        }
+        batch_words = std::max<uint>(batch_words, (components + 63) / 64);
+        x_frames.assign(n * batch_words, 0);
+        z_frames.assign(n * batch_words, 0);
+        flips.assign(n * batch_words, 0);
+
+        // Shot k carries only the k-th random Z component, in the order in which propagate draws them.
+        auto words = (components + 63) / 64;
+        uint component = 0;
+        propagate(words, [&](uint64_t *z) {
+            std::fill(z, z + words, 0);
+            z[component / 64] = uint64_t{1} << (component % 64);
+            ++component;
+        });
+
+        auto qubit_words = (n + 63) / 64;
+        std::vector<uint64_t> offset(qubit_words, 0);
+        std::vector<uint64_t> basis(components * qubit_words, 0);
+        std::vector<uint32_t> kept_qubits;
+        for (auto q: measured_qubits) {
+            kept_qubits.push_back(static_cast<uint32_t>(q));
+            offset[q / 64] |= static_cast<uint64_t>(reference_sample[q] == '1') << (q % 64);
+            for (uint k = 0; k < components; ++k) {
+                auto flip = (flips[q * batch_words + k / 64] >> (k % 64)) & 1;
+                basis[k * qubit_words + q / 64] |= flip << (q % 64);
+            }
+        }
+        OutcomeSpace distribution(n, std::move(offset), std::move(basis));
+        distribution.restrict(kept_qubits);
+        return distribution;
+    }
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "compiled_circuit.h"
+#include "outcome_space.h"
+#include "improved_simulation_of_stabilizer_circuits/subroutines.h"
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace CliffordTableaus {
+    using uint = std::size_t;
+
+    /**
+     * Samples many shots of a circuit without feedback by propagating Pauli frames instead of full tableaus.
+     * A single reference shot is simulated with a stabilizer tableau.
+     * Every other shot differs from the reference only by a Pauli operator, its frame,
+     * which is pushed through the Clifford gates by conjugation and flips a measurement outcome
+     * whenever it has an X component on the measured qubit.
+     * The frames of 64 shots are bit-packed into every word, so a gate costs a few word operations per 64 shots.
+     */
+    class FrameSimulator {
+    private:
+        /**
+         * The circuit to sample.
+         */
+        const CompiledCircuit &circuit;
+
+        /**
+         * The measurement result of the reference shot.
+         */
+        std::string reference_sample;
+
+        /**
+         * The qubits whose entry of the measurement result is a measurement outcome rather than 'x'.
+         */
+        std::vector<uint> measured_qubits;
+
+        /**
+         * The number of 64-bit words per qubit, i.e. the batch holds 64 * batch_words shots.
+         */
+        uint batch_words;
+
+        /**
+         * The X components of the frames, batch_words words per qubit.
+         */
+        std::vector<uint64_t> x_frames;
+
+        /**
+         * The Z components of the frames, batch_words words per qubit.
+         */
+        std::vector<uint64_t> z_frames;
+
+        /**
+         * Per qubit, which shots flipped the outcome of the last measurement relative to the reference shot.
+         */
+        std::vector<uint64_t> flips;
+
+        /**
+         * Push the frames of a batch through the circuit, recording the flips of the measurements.
+         * The Z components of the frames are drawn from randomize, once for every qubit at the start
+         * and once for the measured qubit after every measurement.
+         * @param words Number of words per qubit to simulate, at most batch_words.
+         * @param randomize Called with the Z words of a qubit to overwrite them with fresh random components.
+         */
+        template<class Randomize>
+        void propagate(uint words, Randomize randomize);
+
+    public:
+        /**
+         * Construct a new FrameSimulator for a circuit.
+         * @param p_circuit The circuit to sample, which must outlive the simulator.
+         * @param p_reference_sample Measurement result of one shot of the circuit, e.g. from CompiledCircuit::run.
+         * @param p_batch_words Number of 64-bit words per qubit, i.e. shots are simulated in batches of 64 * p_batch_words.
+         */
+        FrameSimulator(const CompiledCircuit &p_circuit, std::string p_reference_sample, uint p_batch_words = 16);
+
+        /**
+         * Get the maximum number of shots simulated by one call of sampleBatch.
+         * @return The batch size.
+         */
+        [[nodiscard]] uint batchSize() const;
+
+        /**
+         * Simulate a batch of shots and count their measurement results.
+         * @param shots Number of shots, at most batchSize().
+         * @param rng Generator of the random frames.
+         * @param histogram Histogram to add the measurement results to.
+         */
+        void sampleBatch(uint shots, Rng &rng, std::unordered_map<std::string, unsigned int> &histogram);
+
+        /**
+         * Compute the exact distribution of the measurement results instead of sampling it.
+         * The frames propagate linearly, so the flips of a shot are the sum of the flips caused by each
+         * of its random Z components alone. Every shot of the batch is given a single one of these components,
+         * the flips of the shots then span the subspace of the measurement results around the reference sample.
+         * The batch is enlarged to one shot per qubit and measurement, which takes O(gates * (n + m) / 64)
+         * for a circuit of m measurements.
+         * @return The distribution of the measurement results.
+         */
+        OutcomeSpace outcomeSpace();
+    };
+}
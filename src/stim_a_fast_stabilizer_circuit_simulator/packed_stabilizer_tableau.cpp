@@ -0,0 +1,611 @@
+#include "packed_stabilizer_tableau.h"
+#include "simd_kernels.h"
+
+#include <algorithm>
+#include <bit>
+#include <tuple>
+
+namespace CliffordTableaus {
+    void PackedStabilizerTableau::initializeTableau(uint p_n) {
+        column_words = (2 * p_n + 1 + 63) / 64;
+        qubit_words = (p_n + 63) / 64;
+        row_words = 2 * qubit_words + 1;
+        rows.resize((2 * p_n + 1) * row_words);
+        row_major = false;
+        consecutive_measurements = 0;
+        StabilizerTableau::initializeTableau(p_n, (2 * p_n + 1) * column_words * 64);
+        // The initial state |0〉^⊗n has ri = 0 for all i ∈ {1 to 2n + 1},
+        // and xij = δij and zij = δ(i−n)j for all
+        // i ∈ {1 to 2n + 1} and j ∈ {1 to n}.
+        // The storage is zero-initialized, so only the diagonals need to be set.
+        for (uint j = 1; j <= n; ++j) {
+            set_bit(x_column(j), j, 1);
+            set_bit(z_column(j), n + j, 1);
+        }
+    }
+
+    void PackedStabilizerTableau::rowsum_masked(const uint64_t *mask, uint p) {
+        // The exponent of i contributed by each qubit is g(xpj, zpj, xhj, zhj) ∈ {-1, 0, 1}.
+        // For a fixed source generator p the function g only depends on the target bits,
+        // so the +1 and -1 contributions of all target generators can be computed as bit masks.
+        std::vector<uint64_t> lo(column_words, 0);
+        std::vector<uint64_t> hi(column_words, 0);
+        auto &kernels = simd_kernels();
+        for (uint j = 1; j <= n; ++j) {
+            auto x = x_column(j);
+            auto z = z_column(j);
+            auto xpj = get_bit(x, p);
+            auto zpj = get_bit(z, p);
+            if (xpj == 0 && zpj == 0) {
+                continue;
+            }
+            kernels.rowsum_column(x, z, mask, lo.data(), hi.data(), xpj, zpj, column_words);
+        }
+
+        // The total exponent is 2 * (rh + rp) + 2 * hi + lo, which must be congruent to 0 or 2.
+        auto r = r_column();
+        uint64_t rp = get_bit(r, p) ? ~uint64_t{0} : 0;
+        for (uint w = 0; w < column_words; ++w) {
+            if (lo[w] != 0) {
+                throw std::logic_error("Sum_g should never be congruent to 1 or 3.");
+            }
+            r[w] ^= mask[w] & (hi[w] ^ rp);
+        }
+    }
+
+    void PackedStabilizerTableau::CNOT(uint control, uint target) {
+        if (control == 0) {
+            std::cerr << "Attempted to apply CNOT with control = 0!" << std::endl;
+            return;
+        }
+        if (control > n) {
+            std::cerr << "Attempted to apply CNOT with control > n!" << std::endl;
+            return;
+        }
+        if (target == 0) {
+            std::cerr << "Attempted to apply CNOT with target = 0!" << std::endl;
+            return;
+        }
+        if (target > n) {
+            std::cerr << "Attempted to apply CNOT with target > n!" << std::endl;
+            return;
+        }
+        if (control == target) {
+            std::cerr << "Attempted to apply CNOT with target = control!" << std::endl;
+            return;
+        }
+
+        useColumns();
+        simd_kernels().cnot_columns(x_column(control), z_column(control), x_column(target), z_column(target),
+                                    r_column(), column_words);
+    }
+
+    void PackedStabilizerTableau::Hadamard(uint qubit) {
+        if (qubit == 0) {
+            std::cerr << "Attempted to apply Hadamard with qubit = 0!" << std::endl;
+            return;
+        }
+        if (qubit > n) {
+            std::cerr << "Attempted to apply Hadamard with qubit > n!" << std::endl;
+            return;
+        }
+
+        useColumns();
+        simd_kernels().hadamard_columns(x_column(qubit), z_column(qubit), r_column(), column_words);
+    }
+
+    void PackedStabilizerTableau::Phase(uint qubit) {
+        if (qubit == 0) {
+            std::cout << "Attempted to apply Phase with qubit = 0!" << std::endl;
+            return;
+        }
+        if (qubit > n) {
+            std::cout << "Attempted to apply Phase with qubit > n!" << std::endl;
+            return;
+        }
+
+        useColumns();
+        simd_kernels().phase_columns(x_column(qubit), z_column(qubit), r_column(), column_words);
+    }
+
+    uint8_t PackedStabilizerTableau::Measurement(uint qubit) {
+        if (qubit == 0) {
+            throw std::invalid_argument("Attempted to measure qubit = 0!");
+        }
+        if (qubit > n) {
+            throw std::invalid_argument("Attempted to measure qubit > n!");
+        }
+
+        // Long blocks of measurements without gates in between are executed on the rows.
+        if (++consecutive_measurements >= row_major_measurements && !row_major &&
+            find_bit(x_column(qubit), n + 1, 2 * n) == 0) {
+            useRows();
+        }
+        if (row_major) {
+            return measureRows(qubit);
+        }
+
+        // Measurement of qubit a in standard basis.
+        // First check whether there exists a p with n+1<=p<=2*n such that xpa=1.
+        auto a = qubit;
+        auto xa = x_column(a);
+        auto p = find_bit(xa, n + 1, 2 * n);
+        auto r = r_column();
+        if (p != 0) {
+            // Case I: Such a p exists. The outcome is random.
+            // Call rowsum(i,p) for all i ∈ {1 to 2*n} such that i ∉ {p, p-n} and xia = 1.
+            // See ImprovedStabilizerTableau::Measurement for why i = p-n must be excluded.
+            // All of these rowsums are performed at once on the packed columns.
+            std::vector<uint64_t> mask(xa, xa + column_words);
+            set_bit(mask.data(), p, 0);
+            set_bit(mask.data(), p - n, 0);
+            set_bit(mask.data(), 2 * n + 1, 0);
+            rowsum_masked(mask.data(), p);
+
+            // Second, set the entire (p−n)th row equal to the pth row.
+            // Third, set the pth row to be identically 0.
+            for (uint j = 1; j <= n; ++j) {
+                auto x = x_column(j);
+                auto z = z_column(j);
+                set_bit(x, p - n, get_bit(x, p));
+                set_bit(z, p - n, get_bit(z, p));
+                set_bit(x, p, 0);
+                set_bit(z, p, 0);
+            }
+            set_bit(r, p - n, get_bit(r, p));
+
+            // Except that rp is 0 or 1 with equal probability, and zpa = 1.
+            set_bit(r, p, randomBit());
+            set_bit(z_column(a), p, 1);
+
+            // Finally, return rp as the measurement outcome.
+            return get_bit(r, p);
+        }
+
+        // Case II: Such a p does not exist. The outcome is determinate.
+        // It is the phase of the product of the stabilizers n + i for all i ∈ {1 to n} such that xia = 1,
+        // which the paper computes with rowsum (2n+1,i+n) into the scratch space.
+        return determinate_outcome(a);
+    }
+
+    uint8_t PackedStabilizerTableau::measureRows(uint a) {
+        // Same procedure as ImprovedStabilizerTableau::Measurement, see there for the exclusion of i = p-n.
+        auto word = (a - 1) / 64;
+        auto mask = uint64_t{1} << ((a - 1) % 64);
+        auto p = first_x_row(a, n + 1);
+        if (p != 0) {
+            // Case I: The outcome is random.
+            for (uint i = 1; i <= 2 * n; ++i) {
+                if (i != p && i != p - n && (row(i)[word] & mask) != 0) {
+                    rowsum(i, p);
+                }
+            }
+            std::copy(row(p), row(p) + row_words, row(p - n));
+            std::fill(row(p), row(p) + row_words, 0);
+            row(p)[2 * qubit_words] = randomBit();
+            row(p)[qubit_words + word] |= mask;
+            return row(p)[2 * qubit_words];
+        }
+
+        // Case II: The outcome is determinate, call rowsum (2n+1,i+n) for all i ∈ {1 to n} such that xia = 1.
+        auto scratch = row(2 * n + 1);
+        std::fill(scratch, scratch + row_words, 0);
+        for (uint i = 1; i <= n; ++i) {
+            if ((row(i)[word] & mask) != 0) {
+                rowsum(2 * n + 1, i + n);
+            }
+        }
+        return scratch[2 * qubit_words];
+    }
+
+    void PackedStabilizerTableau::rowsum(uint h, uint i) {
+        auto row_h = row(h);
+        auto row_i = row(i);
+        auto &kernels = simd_kernels();
+        int sum_g = 2 * static_cast<int>(row_h[2 * qubit_words] + row_i[2 * qubit_words]) +
+                    kernels.g_packed(row_i, row_i + qubit_words, row_h, row_h + qubit_words, qubit_words);
+        sum_g = ((sum_g % 4) + 4) % 4;
+        if (sum_g == 1 || sum_g == 3) {
+            throw std::logic_error("Sum_g should never be congruent to 1 or 3.");
+        }
+        row_h[2 * qubit_words] = sum_g / 2;
+        // The x and z words are adjacent, so both are XORed in one pass.
+        kernels.xor_words(row_h, row_i, 2 * qubit_words);
+    }
+
+    std::vector<uint8_t> PackedStabilizerTableau::MeasureAll() {
+        // The stabilizers are reduced on a row-major copy, like for the improved tableau.
+        useRows();
+        std::vector<uint64_t> stabilizers(row(n + 1), row(2 * n + 1));
+        auto outcomes = sampleMeasureAll(stabilizers, qubit_words);
+
+        // The measured state is the basis state of the outcomes, whose stabilizers are the Zj with phase bit mj.
+        initializeTableau(n);
+        for (uint j = 1; j <= n; ++j) {
+            set_bit(r_column(), n + j, outcomes[j - 1]);
+        }
+        return outcomes;
+    }
+
+    OutcomeSpace PackedStabilizerTableau::outcomeSpace() {
+        useRows();
+        std::vector<uint64_t> stabilizers(row(n + 1), row(2 * n + 1));
+        return reduceOutcomeSpace(stabilizers, qubit_words);
+    }
+
+    uint8_t PackedStabilizerTableau::determinate_outcome(uint a) {
+        // The stabilizers are selected by the destabilizer half of the x column of the qubit.
+        auto half_words = (n + 63) / 64;
+        auto xa = x_column(a);
+        std::vector<uint64_t> selected(half_words);
+        for (uint w = 0; w < half_words; ++w) {
+            selected[w] = xa[w];
+        }
+        if (n % 64 != 0) {
+            selected[half_words - 1] &= (uint64_t{1} << (n % 64)) - 1;
+        }
+
+        // Only the words selecting at least one stabilizer are visited for every qubit.
+        std::vector<uint> active_words;
+        for (uint w = 0; w < half_words; ++w) {
+            if (selected[w] != 0) {
+                active_words.push_back(w);
+            }
+        }
+
+        // The phases of the selected stabilizers, the scratch space starts with phase 0.
+        int sum_g = 0;
+        auto r = r_column();
+        for (auto w: active_words) {
+            sum_g += 2 * std::popcount(selected[w] & get_word(r, n + 1 + 64 * w));
+        }
+
+        for (uint j = 1; j <= n; ++j) {
+            auto x = x_column(j);
+            auto z = z_column(j);
+            // Writing each Pauli as i^(xz) X^x Z^z, the product of the selected Paulis on qubit j in order is
+            // i^(#Y) (-1)^(#pairs s < t with zs = xt = 1) X^X Z^Z, where X and Z are the parities of the x and z bits.
+            // Relative to the Hermitian Pauli i^(XZ) X^X Z^Z this is the exponent #Y + 2 #pairs - XZ of i.
+            int y_count = 0;
+            uint64_t pair_parity = 0;
+            uint64_t x_parity = 0;
+            // The parity of the z bits of all selected stabilizers before the current word.
+            uint64_t z_carry = 0;
+            for (auto w: active_words) {
+                uint64_t x1 = get_word(x, n + 1 + 64 * w) & selected[w];
+                uint64_t z1 = get_word(z, n + 1 + 64 * w) & selected[w];
+                // Inclusive prefix parities of the z bits, including all previous words.
+                uint64_t prefix_z = z1;
+                for (uint shift = 1; shift < 64; shift <<= 1) {
+                    prefix_z ^= prefix_z << shift;
+                }
+                prefix_z ^= z_carry ? ~uint64_t{0} : 0;
+                // For every stabilizer the parity of the z bits of the stabilizers before it.
+                uint64_t z_before = (prefix_z << 1) | z_carry;
+                z_carry = prefix_z >> 63;
+
+                y_count += std::popcount(x1 & z1);
+                pair_parity ^= std::popcount(z_before & x1) & 1;
+                x_parity ^= std::popcount(x1) & 1;
+            }
+            sum_g += y_count + 2 * static_cast<int>(pair_parity) - static_cast<int>(x_parity & z_carry);
+        }
+        sum_g = ((sum_g % 4) + 4) % 4;
+
+        if (sum_g == 1 || sum_g == 3) {
+            throw std::logic_error("Sum_g should never be congruent to 1 or 3.");
+        }
+        return sum_g / 2;
+    }
+
+    void PackedStabilizerTableau::PauliX(uint qubit) {
+        if (qubit == 0) {
+            std::cerr << "Warning: Attempted to apply Pauli-X with qubit = 0!" << std::endl;
+            return;
+        }
+        if (qubit > n) {
+            std::cerr << "Warning: Attempted to apply Pauli-X with qubit > n!" << std::endl;
+            return;
+        }
+
+        // X anticommutes with Z and Y, so it flips the sign of every generator with zia = 1.
+        useColumns();
+        simd_kernels().xor_words(r_column(), z_column(qubit), column_words);
+    }
+
+    void PackedStabilizerTableau::PauliY(uint qubit) {
+        if (qubit == 0) {
+            std::cerr << "Warning: Attempted to apply Pauli-Y with qubit = 0!" << std::endl;
+            return;
+        }
+        if (qubit > n) {
+            std::cerr << "Warning: Attempted to apply Pauli-Y with qubit > n!" << std::endl;
+            return;
+        }
+
+        // Y anticommutes with X and Z, so it flips the sign of every generator with xia ^ zia = 1.
+        useColumns();
+        auto &kernels = simd_kernels();
+        kernels.xor_words(r_column(), x_column(qubit), column_words);
+        kernels.xor_words(r_column(), z_column(qubit), column_words);
+    }
+
+    void PackedStabilizerTableau::PauliZ(uint qubit) {
+        if (qubit == 0) {
+            std::cerr << "Warning: Attempted to apply Pauli-Z with qubit = 0!" << std::endl;
+            return;
+        }
+        if (qubit > n) {
+            std::cerr << "Warning: Attempted to apply Pauli-Z with qubit > n!" << std::endl;
+            return;
+        }
+
+        // Z anticommutes with X and Y, so it flips the sign of every generator with xia = 1.
+        useColumns();
+        simd_kernels().xor_words(r_column(), x_column(qubit), column_words);
+    }
+
+    void PackedStabilizerTableau::SWAP(uint qubit1, uint qubit2) {
+        if (qubit1 == 0) {
+            std::cerr << "Attempted to apply SWAP with qubit1 = 0!" << std::endl;
+            return;
+        }
+        if (qubit1 > n) {
+            std::cerr << "Attempted to apply SWAP with qubit1 > n!" << std::endl;
+            return;
+        }
+        if (qubit2 == 0) {
+            std::cerr << "Attempted to apply SWAP with qubit2 = 0!" << std::endl;
+            return;
+        }
+        if (qubit2 > n) {
+            std::cerr << "Attempted to apply SWAP with qubit2 > n!" << std::endl;
+            return;
+        }
+        if (qubit1 == qubit2) {
+            return;
+        }
+
+        useColumns();
+        // Exchange the columns of both qubits, the signs are unaffected.
+        std::swap_ranges(x_column(qubit1), x_column(qubit1) + column_words, x_column(qubit2));
+        std::swap_ranges(z_column(qubit1), z_column(qubit1) + column_words, z_column(qubit2));
+    }
+
+    void PackedStabilizerTableau::Clifford(uint qubit, const SingleQubitClifford &clifford) {
+        if (qubit == 0) {
+            std::cerr << "Warning: Attempted to apply Clifford with qubit = 0!" << std::endl;
+            return;
+        }
+        if (qubit > n) {
+            std::cerr << "Warning: Attempted to apply Clifford with qubit > n!" << std::endl;
+            return;
+        }
+
+        useColumns();
+        // Select the image of every generator's Pauli on the qubit with bit masks of the Z, X and Y generators.
+        // Each image bit is either set for all generators with the same Pauli or for none of them.
+        auto spread = [&](uint8_t pauli, unsigned int bit) {
+            return uint64_t{0} - ((clifford.image[pauli] >> bit) & 1u);
+        };
+        uint64_t x_of_z = spread(0b01, 1), z_of_z = spread(0b01, 0), sign_of_z = spread(0b01, 2);
+        uint64_t x_of_x = spread(0b10, 1), z_of_x = spread(0b10, 0), sign_of_x = spread(0b10, 2);
+        uint64_t x_of_y = spread(0b11, 1), z_of_y = spread(0b11, 0), sign_of_y = spread(0b11, 2);
+        auto x = x_column(qubit);
+        auto z = z_column(qubit);
+        auto r = r_column();
+        for (uint w = 0; w < column_words; ++w) {
+            auto is_z = ~x[w] & z[w];
+            auto is_x = x[w] & ~z[w];
+            auto is_y = x[w] & z[w];
+            r[w] ^= (is_z & sign_of_z) | (is_x & sign_of_x) | (is_y & sign_of_y);
+            x[w] = (is_z & x_of_z) | (is_x & x_of_x) | (is_y & x_of_y);
+            z[w] = (is_z & z_of_z) | (is_x & z_of_x) | (is_y & z_of_y);
+        }
+    }
+
+    void PackedStabilizerTableau::saveSnapshot(TableauSnapshot &snapshot) const {
+        StabilizerTableau::saveSnapshot(snapshot);
+        // Snapshots always hold the columns.
+        if (row_major) {
+            rowsToColumns(rows.data(), snapshot.words.data());
+        }
+    }
+
+    void PackedStabilizerTableau::restoreSnapshot(const TableauSnapshot &snapshot) {
+        StabilizerTableau::restoreSnapshot(snapshot);
+        column_words = (2 * n + 1 + 63) / 64;
+        qubit_words = (n + 63) / 64;
+        row_words = 2 * qubit_words + 1;
+        rows.resize((2 * n + 1) * row_words);
+        row_major = false;
+        consecutive_measurements = 0;
+    }
+
+    bool PackedStabilizerTableau::hasRandomOutcome(uint qubit) {
+        if (qubit == 0) {
+            throw std::invalid_argument("Attempted to measure qubit = 0!");
+        }
+        if (qubit > n) {
+            throw std::invalid_argument("Attempted to measure qubit > n!");
+        }
+        // Same check as the first step of Measurement.
+        if (row_major) {
+            return first_x_row(qubit, n + 1) != 0;
+        }
+        return find_bit(x_column(qubit), n + 1, 2 * n) != 0;
+    }
+
+    void PackedStabilizerTableau::useRows() {
+        if (!row_major) {
+            columnsToRows(tableau.data(), rows.data());
+            row_major = true;
+        }
+    }
+
+    void PackedStabilizerTableau::useColumns() {
+        consecutive_measurements = 0;
+        if (row_major) {
+            rowsToColumns(rows.data(), tableau.data());
+            row_major = false;
+        }
+    }
+
+    void PackedStabilizerTableau::columnsToRows(const uint64_t *columns, uint64_t *destination) const {
+        // The x columns, the z columns and the r column are transposed separately,
+        // since each part of a row starts at a word boundary.
+        // Every block covers 64 columns and 64 generators, i.e. one word of each of the 64 columns,
+        // which become one word of each of the 64 rows. Missing columns are filled with zeros.
+        uint64_t block[64];
+        for (auto [first_column, count, offset]: {std::tuple{uint{0}, n, uint{0}},
+                                                  std::tuple{n, n, qubit_words},
+                                                  std::tuple{2 * n, uint{1}, 2 * qubit_words}}) {
+            for (uint column_block = 0; column_block * 64 < count; ++column_block) {
+                auto block_columns = std::min<uint>(64, count - column_block * 64);
+                auto column = columns + (first_column + column_block * 64) * column_words;
+                for (uint w = 0; w < column_words; ++w) {
+                    for (uint k = 0; k < 64; ++k) {
+                        block[k] = k < block_columns ? column[k * column_words + w] : 0;
+                    }
+                    transpose64(block);
+                    auto block_rows = std::min<uint>(64, 2 * n + 1 - w * 64);
+                    for (uint k = 0; k < block_rows; ++k) {
+                        destination[(w * 64 + k) * row_words + offset + column_block] = block[k];
+                    }
+                }
+            }
+        }
+    }
+
+    void PackedStabilizerTableau::rowsToColumns(const uint64_t *source, uint64_t *columns) const {
+        // The inverse of columnsToRows. Missing rows are filled with zeros, which keeps the padding of the columns 0.
+        uint64_t block[64];
+        for (auto [first_column, count, offset]: {std::tuple{uint{0}, n, uint{0}},
+                                                  std::tuple{n, n, qubit_words},
+                                                  std::tuple{2 * n, uint{1}, 2 * qubit_words}}) {
+            for (uint column_block = 0; column_block * 64 < count; ++column_block) {
+                auto block_columns = std::min<uint>(64, count - column_block * 64);
+                auto column = columns + (first_column + column_block * 64) * column_words;
+                for (uint w = 0; w < column_words; ++w) {
+                    auto block_rows = std::min<uint>(64, 2 * n + 1 - w * 64);
+                    for (uint k = 0; k < 64; ++k) {
+                        block[k] = k < block_rows ? source[(w * 64 + k) * row_words + offset + column_block] : 0;
+                    }
+                    transpose64(block);
+                    for (uint k = 0; k < block_columns; ++k) {
+                        column[k * column_words + w] = block[k];
+                    }
+                }
+            }
+        }
+    }
+
+    void PackedStabilizerTableau::transpose64(uint64_t *block) {
+        // Exchange the off-diagonal blocks of 32x32 bits, then those of 16x16 bits within each block and so on.
+        // mask selects the low half of every group of 2 * width bits.
+        uint64_t mask = 0x00000000FFFFFFFF;
+        for (uint width = 32; width != 0; width >>= 1, mask ^= mask << width) {
+            for (uint k = 0; k < 64; k = ((k | width) + 1) & ~width) {
+                uint64_t t = ((block[k] >> width) ^ block[k | width]) & mask;
+                block[k] ^= t << width;
+                block[k | width] ^= t;
+            }
+        }
+    }
+
+    uint64_t *PackedStabilizerTableau::row(uint i) {
+        // Shift the index starting at 1 to index starting at 0
+        return rows.data() + (i - 1) * row_words;
+    }
+
+    uint PackedStabilizerTableau::first_x_row(uint a, uint first) {
+        auto word = (a - 1) / 64;
+        auto mask = uint64_t{1} << ((a - 1) % 64);
+        for (auto i = first; i <= 2 * n; ++i) {
+            if ((row(i)[word] & mask) != 0) {
+                return i;
+            }
+        }
+        return 0;
+    }
+
+    uint64_t *PackedStabilizerTableau::x_column(uint j) {
+        return tableau.data() + (j - 1) * column_words;
+    }
+
+    uint64_t *PackedStabilizerTableau::z_column(uint j) {
+        return tableau.data() + (n + j - 1) * column_words;
+    }
+
+    uint64_t *PackedStabilizerTableau::r_column() {
+        return tableau.data() + 2 * n * column_words;
+    }
+
+    uint8_t PackedStabilizerTableau::get_bit(const uint64_t *column, uint i) {
+        // Shift the index starting at 1 to index starting at 0
+        return (column[(i - 1) / 64] >> ((i - 1) % 64)) & 1;
+    }
+
+    void PackedStabilizerTableau::set_bit(uint64_t *column, uint i, uint8_t value) {
+        // Shift the index starting at 1 to index starting at 0
+        uint64_t bit = uint64_t{1} << ((i - 1) % 64);
+        column[(i - 1) / 64] = (column[(i - 1) / 64] & ~bit) | (value ? bit : 0);
+    }
+
+    uint64_t PackedStabilizerTableau::get_word(const uint64_t *column, uint i) const {
+        // Shift the index starting at 1 to index starting at 0
+        auto word = (i - 1) / 64;
+        auto shift = (i - 1) % 64;
+        uint64_t bits = word < column_words ? column[word] >> shift : 0;
+        if (shift != 0 && word + 1 < column_words) {
+            bits |= column[word + 1] << (64 - shift);
+        }
+        return bits;
+    }
+
+    uint PackedStabilizerTableau::find_bit(const uint64_t *column, uint first, uint last) const {
+        // Shift the indices starting at 1 to indices starting at 0
+        auto begin = first - 1;
+        for (auto word = begin / 64; word * 64 < last; ++word) {
+            auto bits = column[word];
+            if (word == begin / 64) {
+                bits &= ~uint64_t{0} << (begin % 64);
+            }
+            if (bits != 0) {
+                auto i = word * 64 + std::countr_zero(bits) + 1;
+                return i <= last ? i : 0;
+            }
+        }
+        return 0;
+    }
+
+    uint8_t PackedStabilizerTableau::get_x(uint i, uint j) {
+        if (i == 0 || j == 0 || i > 2 * n || j > n) {
+            throw std::invalid_argument("Invalid indices for get_x.");
+        }
+        if (row_major) {
+            return (row(i)[(j - 1) / 64] >> ((j - 1) % 64)) & 1;
+        }
+        return get_bit(x_column(j), i);
+    }
+
+    uint8_t PackedStabilizerTableau::get_z(uint i, uint j) {
+        if (i == 0 || j == 0 || i > 2 * n || j > n) {
+            throw std::invalid_argument("Invalid indices for get_z.");
+        }
+        if (row_major) {
+            return (row(i)[qubit_words + (j - 1) / 64] >> ((j - 1) % 64)) & 1;
+        }
+        return get_bit(z_column(j), i);
+    }
+
+    uint8_t PackedStabilizerTableau::get_r(uint i) {
+        if (i == 0 || i > 2 * n) {
+            throw std::invalid_argument("Invalid index for get_r.");
+        }
+        if (row_major) {
+            return row(i)[2 * qubit_words];
+        }
+        return get_bit(r_column(), i);
+    }
+}
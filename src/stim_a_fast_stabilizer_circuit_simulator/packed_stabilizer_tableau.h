@@ -0,0 +1,274 @@
+#pragma once
+
+#include "improved_simulation_of_stabilizer_circuits/subroutines.h"
+#include "stabilizer_tableau.h"
+
+#include <iostream>
+#include <cassert>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+namespace CliffordTableaus {
+    using uint = std::size_t;
+
+    /**
+     * Stabilizer tableau which stores the x, z and r bits as separate bit-planes packed into 64-bit words.
+     * Every qubit owns one x column and one z column, each spanning all 2n+1 generators (including scratch space).
+     * The phase bits of all generators form one additional r column.
+     * Since the Clifford gates only ever touch the columns of the qubits they act on,
+     * a Hadamard, Phase or CNOT gate becomes a handful of word-wide XOR/AND/swap passes over contiguous memory.
+     * The layout of the words in the tableau is: n x columns, followed by n z columns, followed by the r column.
+     *
+     * Measurements on the other hand operate on whole generators, which are scattered across all columns.
+     * Within a block of measurements without gates in between, the tableau therefore switches to a row-major copy
+     * in the layout of ImprovedStabilizerTableau, transposing the bit matrix in cache-sized blocks of 64x64 bits.
+     * The next gate switches back to the columns. A transposition costs about as much as two determinate
+     * measurements on the columns, and random measurements are faster on the columns, so the switch only happens
+     * at a determinate measurement once the block is long enough. Short blocks stay on the columns.
+     */
+    class PackedStabilizerTableau : public StabilizerTableau {
+    private:
+        /**
+         * The number of 64-bit words needed to store one column of 2n+1 bits.
+         */
+        uint column_words{};
+
+        /**
+         * The number of 64-bit words needed to store the x (or z) bits of one generator in the row-major layout.
+         */
+        uint qubit_words{};
+
+        /**
+         * The number of 64-bit words of one generator in the row-major layout:
+         * the x words, followed by the z words, followed by one word holding the phase bit.
+         */
+        uint row_words{};
+
+        /**
+         * The row-major copy of the tableau, generator i is stored at row(i).
+         * Only up to date while row_major is set.
+         */
+        TableauWords rows;
+
+        /**
+         * Whether the current state is held by the rows instead of the columns.
+         */
+        bool row_major = false;
+
+        /**
+         * The number of measurements since the last gate.
+         */
+        uint consecutive_measurements = 0;
+
+        /**
+         * Determinate measurements switch to the rows from this many measurements since the last gate on.
+         */
+        static constexpr uint row_major_measurements = 4;
+
+        /**
+         * Transpose the columns into the row-major layout, if the state is not held by the rows already.
+         */
+        void useRows();
+
+        /**
+         * Transpose the rows back into the columns, if the state is held by the rows.
+         * Called by every gate.
+         */
+        void useColumns();
+
+        /**
+         * Transpose columns of the tableau into rows, one 64x64 block of bits at a time.
+         * @param columns The column-major words, in the layout of the tableau.
+         * @param destination The row-major words, in the layout of rows.
+         */
+        void columnsToRows(const uint64_t *columns, uint64_t *destination) const;
+
+        /**
+         * Transpose rows back into columns of the tableau, one 64x64 block of bits at a time.
+         * @param source The row-major words, in the layout of rows.
+         * @param columns The column-major words, in the layout of the tableau.
+         */
+        void rowsToColumns(const uint64_t *source, uint64_t *columns) const;
+
+        /**
+         * Transpose a 64x64 bit matrix in place: bit k of word t is exchanged with bit t of word k.
+         * @param block The 64 words of the matrix.
+         */
+        static void transpose64(uint64_t *block);
+
+        /**
+         * Get a pointer to the first word of a generator in the row-major layout.
+         * @param i Index of the generator.
+         * @return Pointer to the row of the generator.
+         */
+        uint64_t *row(uint i);
+
+        /**
+         * Find the first generator from first to 2n whose x bit of a qubit is set in the row-major layout.
+         * @param a Index of the qubit.
+         * @param first Index of the first generator to consider.
+         * @return The index of the generator, or 0 if none of the bits is set.
+         */
+        uint first_x_row(uint a, uint first);
+
+        /**
+         * The rowsum (h, i) of the improved algorithm on the row-major layout, which sets generator h equal to i + h.
+         * @param h The generator to update.
+         * @param i The generator to add to h.
+         */
+        void rowsum(uint h, uint i);
+
+        /**
+         * Measure a qubit on the row-major layout, like ImprovedStabilizerTableau::Measurement.
+         * @param a Index of the measured qubit.
+         * @return The measurement outcome.
+         */
+        uint8_t measureRows(uint a);
+
+        /**
+         * Get a pointer to the first word of the x column of a qubit.
+         * @param j Index of the qubit.
+         * @return Pointer to the x column of the qubit.
+         */
+        uint64_t *x_column(uint j);
+
+        /**
+         * Get a pointer to the first word of the z column of a qubit.
+         * @param j Index of the qubit.
+         * @return Pointer to the z column of the qubit.
+         */
+        uint64_t *z_column(uint j);
+
+        /**
+         * Get a pointer to the first word of the r column.
+         * @return Pointer to the r column.
+         */
+        uint64_t *r_column();
+
+        /**
+         * Read the bit of generator i within a column.
+         * @param column Column to read the bit from.
+         * @param i Index of the generator.
+         * @return The value of the bit.
+         */
+        static uint8_t get_bit(const uint64_t *column, uint i);
+
+        /**
+         * Write the bit of generator i within a column.
+         * @param column Column to write the bit to.
+         * @param i Index of the generator.
+         * @param value The value to which to set the bit to.
+         */
+        static void set_bit(uint64_t *column, uint i, uint8_t value);
+
+        /**
+         * Read the 64 bits of the generators i to i + 63 within a column. Bits beyond the column are 0.
+         * @param column Column to read the bits from.
+         * @param i Index of the first generator.
+         * @return The bits, the one of generator i in the least significant position.
+         */
+        [[nodiscard]] uint64_t get_word(const uint64_t *column, uint i) const;
+
+        /**
+         * Find the first generator among first to last whose bit in a column is set,
+         * skipping over zero words and locating the bit with std::countr_zero.
+         * @param column Column to search.
+         * @param first Index of the first generator to consider.
+         * @param last Index of the last generator to consider.
+         * @return The index of the generator, or 0 if none of the bits is set.
+         */
+        [[nodiscard]] uint find_bit(const uint64_t *column, uint first, uint last) const;
+
+        /**
+         * Compute the outcome of a determinate measurement, i.e. the phase of the product of the stabilizers
+         * n + i for all i ∈ {1 to n} such that xia = 1, without forming the product in the scratch space.
+         * The qubits are processed one column at a time: the phase picked up by the product on a qubit only depends
+         * on the number of Y, the parities of the x and z bits and the parity of the ordered pairs with zs = xt = 1,
+         * which are counted for 64 stabilizers at once with prefix parities and std::popcount.
+         * @param a Index of the measured qubit.
+         * @return The measurement outcome.
+         */
+        uint8_t determinate_outcome(uint a);
+
+        /**
+         * Sets every generator h selected by the mask equal to p + h at once.
+         * The exponents of i of all selected generators are accumulated in parallel
+         * in a two-bit counter per generator, stored as two bit-planes lo and hi.
+         * @param mask Column of bits selecting the generators to update.
+         * @param p The generator to add to all selected generators.
+         */
+        void rowsum_masked(const uint64_t *mask, uint p);
+
+    public:
+        /**
+         * Construct a new PackedStabilizerTableau object.
+         */
+        PackedStabilizerTableau() = default;
+
+        /**
+         * Initialize the tableau with the given number of qubits.
+         * The entries of the tableau will be default initialized to the state |0〉^(⊗n).
+         * @param p_n Number of qubits in the system.
+         */
+        void initializeTableau(uint p_n) override;
+
+        /// Superclass overrides begin.
+        void CNOT(uint control, uint target) override;
+
+        void Hadamard(uint qubit) override;
+
+        void Phase(uint qubit) override;
+
+        uint8_t Measurement(uint qubit) override;
+
+        /**
+         * Transposes the stabilizers into the row-major layout and samples the outcomes from them at once.
+         * @return The outcomes of all qubits, the one of qubit j at index j - 1.
+         */
+        std::vector<uint8_t> MeasureAll() override;
+
+        /**
+         * Transposes the stabilizers into the row-major layout and reduces a copy of them.
+         * @return The distribution of the outcomes of all qubits.
+         */
+        OutcomeSpace outcomeSpace() override;
+
+        void PauliX(uint qubit) override;
+
+        void PauliY(uint qubit) override;
+
+        void PauliZ(uint qubit) override;
+
+        void SWAP(uint qubit1, uint qubit2) override;
+
+        void Clifford(uint qubit, const SingleQubitClifford &clifford) override;
+
+        void saveSnapshot(TableauSnapshot &snapshot) const override;
+
+        void restoreSnapshot(const TableauSnapshot &snapshot) override;
+
+        bool hasRandomOutcome(uint qubit) override;
+        /// Superclass overrides end.
+
+        /**
+         * Get the value of the x operator bit for a qubit.
+         * @param i Index of the generator.
+         * @param j Index of qubit.
+         */
+        uint8_t get_x(uint i, uint j);
+
+        /**
+         * Get the value of the z operator bit for a qubit.
+         * @param i Index of the generator.
+         * @param j Index of qubit.
+         */
+        uint8_t get_z(uint i, uint j);
+
+        /**
+         * Get the value of the phase bit of a generator.
+         * @param i Index of the generator.
+         */
+        uint8_t get_r(uint i);
+    };
+}
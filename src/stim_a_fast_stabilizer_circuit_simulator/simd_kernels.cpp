@@ -0,0 +1,544 @@
+#include "simd_kernels.h"
+#include "improved_simulation_of_stabilizer_circuits/subroutines.h"
+
+#include <atomic>
+#include <stdexcept>
+#include <utility>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define CLIFFORD_TABLEAUS_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+namespace CliffordTableaus {
+    namespace {
+        /// Scalar kernels begin.
+        void hadamard_columns_scalar(uint64_t *x, uint64_t *z, uint64_t *r, uint words) {
+            for (uint w = 0; w < words; ++w) {
+                r[w] ^= x[w] & z[w];
+                std::swap(x[w], z[w]);
+            }
+        }
+
+        void phase_columns_scalar(uint64_t *x, uint64_t *z, uint64_t *r, uint words) {
+            for (uint w = 0; w < words; ++w) {
+                r[w] ^= x[w] & z[w];
+                z[w] ^= x[w];
+            }
+        }
+
+        void cnot_columns_scalar(uint64_t *xa, uint64_t *za, uint64_t *xb, uint64_t *zb, uint64_t *r, uint words) {
+            for (uint w = 0; w < words; ++w) {
+                r[w] ^= xa[w] & zb[w] & ~(xb[w] ^ za[w]);
+                xb[w] ^= xa[w];
+                za[w] ^= zb[w];
+            }
+        }
+
+        void rowsum_column_scalar(uint64_t *x, uint64_t *z, const uint64_t *mask, uint64_t *lo, uint64_t *hi,
+                                  uint8_t xp, uint8_t zp, uint words) {
+            // For a fixed source Pauli (xp, zp) the function g only depends on the target bits:
+            // X: +1 on Y, -1 on Z. Y: +1 on Z, -1 on X. Z: +1 on X, -1 on Y.
+            uint64_t source_x = xp ? ~uint64_t{0} : 0;
+            uint64_t source_z = zp ? ~uint64_t{0} : 0;
+            uint64_t source_y = source_x & source_z;
+            source_x &= ~source_y;
+            source_z &= ~source_y;
+            for (uint w = 0; w < words; ++w) {
+                uint64_t x2 = x[w];
+                uint64_t z2 = z[w];
+                uint64_t plus = (source_x & x2 & z2) | (source_y & ~x2 & z2) | (source_z & x2 & ~z2);
+                uint64_t minus = (source_x & ~x2 & z2) | (source_y & x2 & ~z2) | (source_z & x2 & z2);
+                plus &= mask[w];
+                minus &= mask[w];
+
+                // Increment and decrement the two-bit counters modulo 4.
+                hi[w] ^= lo[w] & plus;
+                lo[w] ^= plus;
+                lo[w] ^= minus;
+                hi[w] ^= lo[w] & minus;
+
+                x[w] = x2 ^ (mask[w] & (xp ? ~uint64_t{0} : 0));
+                z[w] = z2 ^ (mask[w] & (zp ? ~uint64_t{0} : 0));
+            }
+        }
+        /// Scalar kernels end.
+
+        const SimdKernels scalar_kernels = {
+                xor_words,
+                g_packed,
+                hadamard_columns_scalar,
+                phase_columns_scalar,
+                cnot_columns_scalar,
+                rowsum_column_scalar
+        };
+
+#ifdef CLIFFORD_TABLEAUS_X86_KERNELS
+        /// AVX2 kernels begin.
+        __attribute__((target("avx2")))
+        __m256i load256(const uint64_t *address) {
+            return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(address));
+        }
+
+        __attribute__((target("avx2")))
+        void store256(uint64_t *address, __m256i value) {
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(address), value);
+        }
+
+        /**
+         * Population count of each 64-bit lane using the nibble lookup table of Muła et al.
+         */
+        __attribute__((target("avx2")))
+        __m256i popcount256(__m256i v) {
+            const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                                    0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+            const __m256i low_mask = _mm256_set1_epi8(0x0f);
+            __m256i low = _mm256_and_si256(v, low_mask);
+            __m256i high = _mm256_and_si256(_mm256_srli_epi16(v, 4), low_mask);
+            __m256i counts = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, low), _mm256_shuffle_epi8(lookup, high));
+            return _mm256_sad_epu8(counts, _mm256_setzero_si256());
+        }
+
+        __attribute__((target("avx2")))
+        void xor_words_avx2(uint64_t *destination, const uint64_t *source, uint words) {
+            uint w = 0;
+            for (; w + 4 <= words; w += 4) {
+                store256(destination + w, _mm256_xor_si256(load256(destination + w), load256(source + w)));
+            }
+            xor_words(destination + w, source + w, words - w);
+        }
+
+        __attribute__((target("avx2")))
+        int g_packed_avx2(const uint64_t *x1, const uint64_t *z1, const uint64_t *x2, const uint64_t *z2, uint words) {
+            __m256i plus_count = _mm256_setzero_si256();
+            __m256i minus_count = _mm256_setzero_si256();
+            uint w = 0;
+            for (; w + 4 <= words; w += 4) {
+                __m256i vx1 = load256(x1 + w);
+                __m256i vz1 = load256(z1 + w);
+                __m256i vx2 = load256(x2 + w);
+                __m256i vz2 = load256(z2 + w);
+                __m256i pauli_x = _mm256_andnot_si256(vz1, vx1);
+                __m256i pauli_y = _mm256_and_si256(vx1, vz1);
+                __m256i pauli_z = _mm256_andnot_si256(vx1, vz1);
+                __m256i x2_and_z2 = _mm256_and_si256(vx2, vz2);
+                __m256i only_z2 = _mm256_andnot_si256(vx2, vz2);
+                __m256i only_x2 = _mm256_andnot_si256(vz2, vx2);
+                __m256i plus = _mm256_or_si256(_mm256_and_si256(pauli_x, x2_and_z2),
+                                               _mm256_or_si256(_mm256_and_si256(pauli_y, only_z2),
+                                                               _mm256_and_si256(pauli_z, only_x2)));
+                __m256i minus = _mm256_or_si256(_mm256_and_si256(pauli_x, only_z2),
+                                                _mm256_or_si256(_mm256_and_si256(pauli_y, only_x2),
+                                                                _mm256_and_si256(pauli_z, x2_and_z2)));
+                plus_count = _mm256_add_epi64(plus_count, popcount256(plus));
+                minus_count = _mm256_add_epi64(minus_count, popcount256(minus));
+            }
+            alignas(32) int64_t lanes[4];
+            _mm256_store_si256(reinterpret_cast<__m256i *>(lanes), _mm256_sub_epi64(plus_count, minus_count));
+            auto sum_g = static_cast<int>(lanes[0] + lanes[1] + lanes[2] + lanes[3]);
+            return sum_g + g_packed(x1 + w, z1 + w, x2 + w, z2 + w, words - w);
+        }
+
+        __attribute__((target("avx2")))
+        void hadamard_columns_avx2(uint64_t *x, uint64_t *z, uint64_t *r, uint words) {
+            uint w = 0;
+            for (; w + 4 <= words; w += 4) {
+                __m256i vx = load256(x + w);
+                __m256i vz = load256(z + w);
+                store256(r + w, _mm256_xor_si256(load256(r + w), _mm256_and_si256(vx, vz)));
+                store256(x + w, vz);
+                store256(z + w, vx);
+            }
+            hadamard_columns_scalar(x + w, z + w, r + w, words - w);
+        }
+
+        __attribute__((target("avx2")))
+        void phase_columns_avx2(uint64_t *x, uint64_t *z, uint64_t *r, uint words) {
+            uint w = 0;
+            for (; w + 4 <= words; w += 4) {
+                __m256i vx = load256(x + w);
+                __m256i vz = load256(z + w);
+                store256(r + w, _mm256_xor_si256(load256(r + w), _mm256_and_si256(vx, vz)));
+                store256(z + w, _mm256_xor_si256(vz, vx));
+            }
+            phase_columns_scalar(x + w, z + w, r + w, words - w);
+        }
+
+        __attribute__((target("avx2")))
+        void cnot_columns_avx2(uint64_t *xa, uint64_t *za, uint64_t *xb, uint64_t *zb, uint64_t *r, uint words) {
+            uint w = 0;
+            for (; w + 4 <= words; w += 4) {
+                __m256i vxa = load256(xa + w);
+                __m256i vza = load256(za + w);
+                __m256i vxb = load256(xb + w);
+                __m256i vzb = load256(zb + w);
+                __m256i flip = _mm256_andnot_si256(_mm256_xor_si256(vxb, vza), _mm256_and_si256(vxa, vzb));
+                store256(r + w, _mm256_xor_si256(load256(r + w), flip));
+                store256(xb + w, _mm256_xor_si256(vxb, vxa));
+                store256(za + w, _mm256_xor_si256(vza, vzb));
+            }
+            cnot_columns_scalar(xa + w, za + w, xb + w, zb + w, r + w, words - w);
+        }
+
+        __attribute__((target("avx2")))
+        void rowsum_column_avx2(uint64_t *x, uint64_t *z, const uint64_t *mask, uint64_t *lo, uint64_t *hi,
+                                uint8_t xp, uint8_t zp, uint words) {
+            __m256i source_x = _mm256_set1_epi64x(xp && !zp ? -1 : 0);
+            __m256i source_y = _mm256_set1_epi64x(xp && zp ? -1 : 0);
+            __m256i source_z = _mm256_set1_epi64x(!xp && zp ? -1 : 0);
+            __m256i flip_x = _mm256_set1_epi64x(xp ? -1 : 0);
+            __m256i flip_z = _mm256_set1_epi64x(zp ? -1 : 0);
+            uint w = 0;
+            for (; w + 4 <= words; w += 4) {
+                __m256i vx = load256(x + w);
+                __m256i vz = load256(z + w);
+                __m256i vmask = load256(mask + w);
+                __m256i x2_and_z2 = _mm256_and_si256(vx, vz);
+                __m256i only_z2 = _mm256_andnot_si256(vx, vz);
+                __m256i only_x2 = _mm256_andnot_si256(vz, vx);
+                __m256i plus = _mm256_or_si256(_mm256_and_si256(source_x, x2_and_z2),
+                                               _mm256_or_si256(_mm256_and_si256(source_y, only_z2),
+                                                               _mm256_and_si256(source_z, only_x2)));
+                __m256i minus = _mm256_or_si256(_mm256_and_si256(source_x, only_z2),
+                                                _mm256_or_si256(_mm256_and_si256(source_y, only_x2),
+                                                                _mm256_and_si256(source_z, x2_and_z2)));
+                plus = _mm256_and_si256(plus, vmask);
+                minus = _mm256_and_si256(minus, vmask);
+
+                __m256i vlo = load256(lo + w);
+                __m256i vhi = load256(hi + w);
+                vhi = _mm256_xor_si256(vhi, _mm256_and_si256(vlo, plus));
+                vlo = _mm256_xor_si256(vlo, _mm256_xor_si256(plus, minus));
+                vhi = _mm256_xor_si256(vhi, _mm256_and_si256(vlo, minus));
+                store256(lo + w, vlo);
+                store256(hi + w, vhi);
+
+                store256(x + w, _mm256_xor_si256(vx, _mm256_and_si256(vmask, flip_x)));
+                store256(z + w, _mm256_xor_si256(vz, _mm256_and_si256(vmask, flip_z)));
+            }
+            rowsum_column_scalar(x + w, z + w, mask + w, lo + w, hi + w, xp, zp, words - w);
+        }
+        /// AVX2 kernels end.
+
+        const SimdKernels avx2_kernels = {
+                xor_words_avx2,
+                g_packed_avx2,
+                hadamard_columns_avx2,
+                phase_columns_avx2,
+                cnot_columns_avx2,
+                rowsum_column_avx2
+        };
+
+        /// AVX-512 kernels begin.
+        __attribute__((target("avx512f")))
+        __m512i load512(const uint64_t *address) {
+            return _mm512_loadu_si512(address);
+        }
+
+        __attribute__((target("avx512f")))
+        void store512(uint64_t *address, __m512i value) {
+            _mm512_storeu_si512(address, value);
+        }
+
+        /**
+         * ~a & b. GCC 12 implements _mm512_andnot_si512 on an undefined pass-through operand
+         * and warns about it, the compiler still emits a single vpandnq for this form.
+         */
+        __attribute__((target("avx512f")))
+        __m512i andnot512(__m512i a, __m512i b) {
+            return _mm512_and_si512(_mm512_xor_si512(a, _mm512_set1_epi64(-1)), b);
+        }
+
+        /**
+         * Population count of each 64-bit lane with AVX-512F alone, which has neither vpopcntq nor a 512-bit
+         * byte shuffle, by counting the two 256-bit halves with the AVX2 nibble lookup table.
+         */
+        __attribute__((target("avx512f")))
+        __m512i popcount512(__m512i v) {
+            __m256i low = popcount256(_mm512_extracti64x4_epi64(v, 0));
+            __m256i high = popcount256(_mm512_extracti64x4_epi64(v, 1));
+            return _mm512_inserti64x4(_mm512_castsi256_si512(low), high, 1);
+        }
+
+        __attribute__((target("avx512f")))
+        void xor_words_avx512(uint64_t *destination, const uint64_t *source, uint words) {
+            uint w = 0;
+            for (; w + 8 <= words; w += 8) {
+                store512(destination + w, _mm512_xor_si512(load512(destination + w), load512(source + w)));
+            }
+            xor_words(destination + w, source + w, words - w);
+        }
+
+        /**
+         * The lanes of plus and minus mark the qubits on which g of two packed generators is +1 and -1.
+         */
+        __attribute__((target("avx512f")))
+        void g_products512(const uint64_t *x1, const uint64_t *z1, const uint64_t *x2, const uint64_t *z2,
+                           __m512i &plus, __m512i &minus) {
+            __m512i vx1 = load512(x1);
+            __m512i vz1 = load512(z1);
+            __m512i vx2 = load512(x2);
+            __m512i vz2 = load512(z2);
+            __m512i pauli_x = andnot512(vz1, vx1);
+            __m512i pauli_y = _mm512_and_si512(vx1, vz1);
+            __m512i pauli_z = andnot512(vx1, vz1);
+            __m512i x2_and_z2 = _mm512_and_si512(vx2, vz2);
+            __m512i only_z2 = andnot512(vx2, vz2);
+            __m512i only_x2 = andnot512(vz2, vx2);
+            plus = _mm512_or_si512(_mm512_and_si512(pauli_x, x2_and_z2),
+                                   _mm512_or_si512(_mm512_and_si512(pauli_y, only_z2),
+                                                   _mm512_and_si512(pauli_z, only_x2)));
+            minus = _mm512_or_si512(_mm512_and_si512(pauli_x, only_z2),
+                                    _mm512_or_si512(_mm512_and_si512(pauli_y, only_x2),
+                                                    _mm512_and_si512(pauli_z, x2_and_z2)));
+        }
+
+        /**
+         * Sum of the eight lanes of plus_count - minus_count.
+         */
+        __attribute__((target("avx512f")))
+        int sum_lanes512(__m512i plus_count, __m512i minus_count) {
+            alignas(64) int64_t lanes[8];
+            _mm512_store_si512(lanes, _mm512_sub_epi64(plus_count, minus_count));
+            int64_t sum_g = 0;
+            for (auto lane: lanes) {
+                sum_g += lane;
+            }
+            return static_cast<int>(sum_g);
+        }
+
+        __attribute__((target("avx512f")))
+        int g_packed_avx512(const uint64_t *x1, const uint64_t *z1, const uint64_t *x2, const uint64_t *z2,
+                            uint words) {
+            __m512i plus_count = _mm512_setzero_si512();
+            __m512i minus_count = _mm512_setzero_si512();
+            uint w = 0;
+            for (; w + 8 <= words; w += 8) {
+                __m512i plus, minus;
+                g_products512(x1 + w, z1 + w, x2 + w, z2 + w, plus, minus);
+                plus_count = _mm512_add_epi64(plus_count, popcount512(plus));
+                minus_count = _mm512_add_epi64(minus_count, popcount512(minus));
+            }
+            return sum_lanes512(plus_count, minus_count) + g_packed(x1 + w, z1 + w, x2 + w, z2 + w, words - w);
+        }
+
+        __attribute__((target("avx512f,avx512vpopcntdq")))
+        int g_packed_avx512_vpopcntdq(const uint64_t *x1, const uint64_t *z1, const uint64_t *x2, const uint64_t *z2,
+                                      uint words) {
+            __m512i plus_count = _mm512_setzero_si512();
+            __m512i minus_count = _mm512_setzero_si512();
+            uint w = 0;
+            for (; w + 8 <= words; w += 8) {
+                __m512i plus, minus;
+                g_products512(x1 + w, z1 + w, x2 + w, z2 + w, plus, minus);
+                plus_count = _mm512_add_epi64(plus_count, _mm512_popcnt_epi64(plus));
+                minus_count = _mm512_add_epi64(minus_count, _mm512_popcnt_epi64(minus));
+            }
+            return sum_lanes512(plus_count, minus_count) + g_packed(x1 + w, z1 + w, x2 + w, z2 + w, words - w);
+        }
+
+        __attribute__((target("avx512f")))
+        void hadamard_columns_avx512(uint64_t *x, uint64_t *z, uint64_t *r, uint words) {
+            uint w = 0;
+            for (; w + 8 <= words; w += 8) {
+                __m512i vx = load512(x + w);
+                __m512i vz = load512(z + w);
+                store512(r + w, _mm512_xor_si512(load512(r + w), _mm512_and_si512(vx, vz)));
+                store512(x + w, vz);
+                store512(z + w, vx);
+            }
+            hadamard_columns_scalar(x + w, z + w, r + w, words - w);
+        }
+
+        __attribute__((target("avx512f")))
+        void phase_columns_avx512(uint64_t *x, uint64_t *z, uint64_t *r, uint words) {
+            uint w = 0;
+            for (; w + 8 <= words; w += 8) {
+                __m512i vx = load512(x + w);
+                __m512i vz = load512(z + w);
+                store512(r + w, _mm512_xor_si512(load512(r + w), _mm512_and_si512(vx, vz)));
+                store512(z + w, _mm512_xor_si512(vz, vx));
+            }
+            phase_columns_scalar(x + w, z + w, r + w, words - w);
+        }
+
+        __attribute__((target("avx512f")))
+        void cnot_columns_avx512(uint64_t *xa, uint64_t *za, uint64_t *xb, uint64_t *zb, uint64_t *r, uint words) {
+            uint w = 0;
+            for (; w + 8 <= words; w += 8) {
+                __m512i vxa = load512(xa + w);
+                __m512i vza = load512(za + w);
+                __m512i vxb = load512(xb + w);
+                __m512i vzb = load512(zb + w);
+                __m512i flip = andnot512(_mm512_xor_si512(vxb, vza), _mm512_and_si512(vxa, vzb));
+                store512(r + w, _mm512_xor_si512(load512(r + w), flip));
+                store512(xb + w, _mm512_xor_si512(vxb, vxa));
+                store512(za + w, _mm512_xor_si512(vza, vzb));
+            }
+            cnot_columns_scalar(xa + w, za + w, xb + w, zb + w, r + w, words - w);
+        }
+
+        __attribute__((target("avx512f")))
+        void rowsum_column_avx512(uint64_t *x, uint64_t *z, const uint64_t *mask, uint64_t *lo, uint64_t *hi,
+                                  uint8_t xp, uint8_t zp, uint words) {
+            __m512i source_x = _mm512_set1_epi64(xp && !zp ? -1 : 0);
+            __m512i source_y = _mm512_set1_epi64(xp && zp ? -1 : 0);
+            __m512i source_z = _mm512_set1_epi64(!xp && zp ? -1 : 0);
+            __m512i flip_x = _mm512_set1_epi64(xp ? -1 : 0);
+            __m512i flip_z = _mm512_set1_epi64(zp ? -1 : 0);
+            uint w = 0;
+            for (; w + 8 <= words; w += 8) {
+                __m512i vx = load512(x + w);
+                __m512i vz = load512(z + w);
+                __m512i vmask = load512(mask + w);
+                __m512i x2_and_z2 = _mm512_and_si512(vx, vz);
+                __m512i only_z2 = andnot512(vx, vz);
+                __m512i only_x2 = andnot512(vz, vx);
+                __m512i plus = _mm512_or_si512(_mm512_and_si512(source_x, x2_and_z2),
+                                               _mm512_or_si512(_mm512_and_si512(source_y, only_z2),
+                                                               _mm512_and_si512(source_z, only_x2)));
+                __m512i minus = _mm512_or_si512(_mm512_and_si512(source_x, only_z2),
+                                                _mm512_or_si512(_mm512_and_si512(source_y, only_x2),
+                                                                _mm512_and_si512(source_z, x2_and_z2)));
+                plus = _mm512_and_si512(plus, vmask);
+                minus = _mm512_and_si512(minus, vmask);
+
+                __m512i vlo = load512(lo + w);
+                __m512i vhi = load512(hi + w);
+                vhi = _mm512_xor_si512(vhi, _mm512_and_si512(vlo, plus));
+                vlo = _mm512_xor_si512(vlo, _mm512_xor_si512(plus, minus));
+                vhi = _mm512_xor_si512(vhi, _mm512_and_si512(vlo, minus));
+                store512(lo + w, vlo);
+                store512(hi + w, vhi);
+
+                store512(x + w, _mm512_xor_si512(vx, _mm512_and_si512(vmask, flip_x)));
+                store512(z + w, _mm512_xor_si512(vz, _mm512_and_si512(vmask, flip_z)));
+            }
+            rowsum_column_scalar(x + w, z + w, mask + w, lo + w, hi + w, xp, zp, words - w);
+        }
+        /// AVX-512 kernels end.
+
+        const SimdKernels avx512_kernels = {
+                xor_words_avx512,
+                g_packed_avx512,
+                hadamard_columns_avx512,
+                phase_columns_avx512,
+                cnot_columns_avx512,
+                rowsum_column_avx512
+        };
+
+        const SimdKernels avx512_vpopcntdq_kernels = {
+                xor_words_avx512,
+                g_packed_avx512_vpopcntdq,
+                hadamard_columns_avx512,
+                phase_columns_avx512,
+                cnot_columns_avx512,
+                rowsum_column_avx512
+        };
+#endif
+
+        /**
+         * The currently selected kernels, nullptr until first use. Worker threads may reach their first kernel
+         * at the same time, so the selection is a single atomic pointer from which the level is derived.
+         */
+        std::atomic<const SimdKernels *> active_kernels = nullptr;
+
+        SimdLevel level_of(const SimdKernels *kernels) {
+#ifdef CLIFFORD_TABLEAUS_X86_KERNELS
+            if (kernels == &avx512_vpopcntdq_kernels) {
+                return SIMD_AVX512_VPOPCNTDQ;
+            }
+            if (kernels == &avx512_kernels) {
+                return SIMD_AVX512;
+            }
+            if (kernels == &avx2_kernels) {
+                return SIMD_AVX2;
+            }
+#endif
+            return SIMD_SCALAR;
+        }
+    }
+
+    SimdLevel detect_simd_level() {
+#ifdef CLIFFORD_TABLEAUS_X86_KERNELS
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512vpopcntdq")) {
+            return SIMD_AVX512_VPOPCNTDQ;
+        }
+        if (__builtin_cpu_supports("avx512f")) {
+            return SIMD_AVX512;
+        }
+        if (__builtin_cpu_supports("avx2")) {
+            return SIMD_AVX2;
+        }
+#endif
+        return SIMD_SCALAR;
+    }
+
+    const SimdKernels &simd_kernels(SimdLevel level) {
+        if (level > detect_simd_level()) {
+            throw std::invalid_argument("SIMD level " + simd_level_name(level) + " is not supported by this CPU.");
+        }
+        switch (level) {
+#ifdef CLIFFORD_TABLEAUS_X86_KERNELS
+            case SIMD_AVX512_VPOPCNTDQ:
+                return avx512_vpopcntdq_kernels;
+            case SIMD_AVX512:
+                return avx512_kernels;
+            case SIMD_AVX2:
+                return avx2_kernels;
+#endif
+            default:
+                return scalar_kernels;
+        }
+    }
+
+    void select_simd_level(SimdLevel level) {
+        active_kernels.store(&simd_kernels(level), std::memory_order_release);
+    }
+
+    SimdLevel active_simd_level() {
+        return level_of(&simd_kernels());
+    }
+
+    const SimdKernels &simd_kernels() {
+        auto kernels = active_kernels.load(std::memory_order_acquire);
+        if (kernels == nullptr) {
+            // The detection runs once, and an explicit selection made in the meantime is kept.
+            static const SimdKernels &detected = simd_kernels(detect_simd_level());
+            if (active_kernels.compare_exchange_strong(kernels, &detected, std::memory_order_acq_rel)) {
+                kernels = &detected;
+            }
+        }
+        return *kernels;
+    }
+
+    SimdLevel parse_simd_level(const std::string &name) {
+        if (name == "scalar") {
+            return SIMD_SCALAR;
+        }
+        if (name == "avx2") {
+            return SIMD_AVX2;
+        }
+        if (name == "avx512") {
+            return SIMD_AVX512;
+        }
+        if (name == "avx512vpopcntdq") {
+            return SIMD_AVX512_VPOPCNTDQ;
+        }
+        throw std::invalid_argument("Unknown SIMD level: " + name);
+    }
+
+    std::string simd_level_name(SimdLevel level) {
+        switch (level) {
+            case SIMD_AVX2:
+                return "avx2";
+            case SIMD_AVX512:
+                return "avx512";
+            case SIMD_AVX512_VPOPCNTDQ:
+                return "avx512vpopcntdq";
+            default:
+                return "scalar";
+        }
+    }
+}
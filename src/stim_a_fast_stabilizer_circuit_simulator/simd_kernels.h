@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace CliffordTableaus {
+    using uint = std::size_t;
+
+    /**
+     * Instruction set extensions for which kernels are available.
+     * Every level implies the levels below it.
+     */
+    enum SimdLevel {
+        SIMD_SCALAR,
+        SIMD_AVX2,
+        SIMD_AVX512,
+        SIMD_AVX512_VPOPCNTDQ
+    };
+
+    /**
+     * Table of the word-parallel kernels used by the tableau updates.
+     * One table exists per SimdLevel, the active one is chosen once at startup by CPUID dispatch
+     * and can be overridden with select_simd_level.
+     * All kernels operate on arrays of 64-bit words of the given length, which may be of any size.
+     */
+    struct SimdKernels {
+        /**
+         * destination ^= source.
+         */
+        void (*xor_words)(uint64_t *destination, const uint64_t *source, uint words);
+
+        /**
+         * Sum of g over all qubits of two packed generators, see g_packed in subroutines.h.
+         */
+        int (*g_packed)(const uint64_t *x1, const uint64_t *z1, const uint64_t *x2, const uint64_t *z2, uint words);
+
+        /**
+         * Hadamard gate on the columns x and z of one qubit: r ^= x & z, then swap x and z.
+         */
+        void (*hadamard_columns)(uint64_t *x, uint64_t *z, uint64_t *r, uint words);
+
+        /**
+         * Phase gate on the columns x and z of one qubit: r ^= x & z, then z ^= x.
+         */
+        void (*phase_columns)(uint64_t *x, uint64_t *z, uint64_t *r, uint words);
+
+        /**
+         * CNOT gate on the columns of control a and target b: r ^= xa & zb & ~(xb ^ za), then xb ^= xa, za ^= zb.
+         */
+        void (*cnot_columns)(uint64_t *xa, uint64_t *za, uint64_t *xb, uint64_t *zb, uint64_t *r, uint words);
+
+        /**
+         * One qubit of a masked rowsum on packed columns: for all generators h selected by the mask
+         * accumulate g(xp, zp, xh, zh) into the two-bit counters (lo, hi), then XOR (xp, zp) into (xh, zh).
+         */
+        void (*rowsum_column)(uint64_t *x, uint64_t *z, const uint64_t *mask, uint64_t *lo, uint64_t *hi,
+                              uint8_t xp, uint8_t zp, uint words);
+    };
+
+    /**
+     * Determine the best SimdLevel supported by the executing CPU.
+     * @return The highest supported SimdLevel.
+     */
+    SimdLevel detect_simd_level();
+
+    /**
+     * Select the kernels of the given level for all subsequent tableau updates.
+     * Safe to call concurrently with simd_kernels, but threads already running keep using the kernels they hold.
+     * Throws an invalid argument exception if the executing CPU does not support the level.
+     * @param level Level of the kernels to use.
+     */
+    void select_simd_level(SimdLevel level);
+
+    /**
+     * Get the level of the currently selected kernels.
+     * @return The active SimdLevel.
+     */
+    SimdLevel active_simd_level();
+
+    /**
+     * Get the currently selected kernels. Defaults to the kernels of detect_simd_level().
+     * Thread-safe, the default is selected once even if several worker threads reach their first kernel at once.
+     * @return Table of the active kernels.
+     */
+    const SimdKernels &simd_kernels();
+
+    /**
+     * Get the kernels of a specific level regardless of the selection, e.g. to compare them against each other.
+     * Throws an invalid argument exception if the executing CPU does not support the level.
+     * @param level Level of the kernels.
+     * @return Table of the kernels.
+     */
+    const SimdKernels &simd_kernels(SimdLevel level);
+
+    /**
+     * Parse a SimdLevel from its name: "scalar", "avx2", "avx512" or "avx512vpopcntdq".
+     * @param name Name of the level.
+     * @return The parsed SimdLevel.
+     */
+    SimdLevel parse_simd_level(const std::string &name);
+
+    /**
+     * Get the name of a SimdLevel.
+     * @param level The SimdLevel.
+     * @return The name of the level: "scalar", "avx2", "avx512" or "avx512vpopcntdq".
+     */
+    std::string simd_level_name(SimdLevel level);
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "gtest/gtest.h"
+
+#include <random>
+
+/**
+ * Apply the same random sequence of gates to two tableaus of n qubits, for differential tests.
+ * The gates are Hadamard, Phase, the Paulis, SWAP and CNOT on two distinct qubits if n >= 2, and optionally
+ * measurements. A measurement step measures two random qubits in the order a, b, a, b, a, so that consecutive
+ * measurements are covered, the repeated ones being determinate.
+ * Both tableaus draw their random outcomes independently, so their phases only agree as long as all outcomes did.
+ * The sequence stops at the first fatal failure, wrap the call in ASSERT_NO_FATAL_FAILURE to stop the test as well.
+ * @param first The first tableau, initialized to n qubits.
+ * @param second The second tableau, initialized to n qubits.
+ * @param generator The source of the random gates.
+ * @param n The number of qubits.
+ * @param steps The number of gates and measurement steps to apply.
+ * @param measurements Whether to include measurement steps.
+ * @param check Called after every step with the step and whether all measurement outcomes agreed so far.
+ * @return Whether all measurement outcomes agreed.
+ */
+template<typename TableauA, typename TableauB, typename Check>
+bool apply_random_gates(TableauA &first, TableauB &second, std::mt19937 &generator, unsigned int n,
+                        unsigned int steps, bool measurements, Check check) {
+    std::uniform_int_distribution<unsigned int> qubit_dist(1, n);
+    std::uniform_int_distribution<int> gate_dist(measurements ? 0 : 1, n >= 2 ? 7 : 5);
+    bool outcomes_agree = true;
+    for (unsigned int step = 0; step < steps; ++step) {
+        auto a = qubit_dist(generator);
+        auto b = qubit_dist(generator);
+        while (n >= 2 && b == a) {
+            b = qubit_dist(generator);
+        }
+        switch (gate_dist(generator)) {
+            case 0:
+                for (auto qubit: {a, b, a, b, a}) {
+                    auto first_outcome = first.Measurement(qubit);
+                    auto second_outcome = second.Measurement(qubit);
+                    outcomes_agree = outcomes_agree && first_outcome == second_outcome;
+                }
+                break;
+            case 1:
+                first.Hadamard(a);
+                second.Hadamard(a);
+                break;
+            case 2:
+                first.Phase(a);
+                second.Phase(a);
+                break;
+            case 3:
+                first.PauliX(a);
+                second.PauliX(a);
+                break;
+            case 4:
+                first.PauliY(a);
+                second.PauliY(a);
+                break;
+            case 5:
+                first.PauliZ(a);
+                second.PauliZ(a);
+                break;
+            case 6:
+                first.SWAP(a, b);
+                second.SWAP(a, b);
+                break;
+            default:
+                first.CNOT(a, b);
+                second.CNOT(a, b);
+                break;
+        }
+        check(step, outcomes_agree);
+        if (::testing::Test::HasFatalFailure()) {
+            break;
+        }
+    }
+    return outcomes_agree;
+}
+
+/**
+ * Apply the same random sequence of gates to two tableaus of n qubits without checking them in between.
+ * @return Whether all measurement outcomes agreed.
+ */
+template<typename TableauA, typename TableauB>
+bool apply_random_gates(TableauA &first, TableauB &second, std::mt19937 &generator, unsigned int n,
+                        unsigned int steps, bool measurements) {
+    return apply_random_gates(first, second, generator, n, steps, measurements, [](unsigned int, bool) {});
+}
@@ -1,14 +1,615 @@
 #include "stabilizer_circuit.h"
+#include "compiled_circuit.h"
+#include "qasm_reader.h"
+#include "binary_circuit.h"
+#include "circuit_optimizer.h"
+#include "shot_runner.h"
+#include "instrumentation.h"
+#include "single_qubit_clifford.h"
+#include "improved_simulation_of_stabilizer_circuits/fixed_stabilizer_tableau.h"
 #include "improved_simulation_of_stabilizer_circuits/improved_stabilizer_tableau.h"
+#include "stim_a_fast_stabilizer_circuit_simulator/packed_stabilizer_tableau.h"
+#include "sparse_stabilizer_tableau/sparse_stabilizer_tableau.h"
+#include "stim_a_fast_stabilizer_circuit_simulator/frame_simulator.h"
 #include "gtest/gtest.h"
+#include "random_gates.h"
 
+#include <algorithm>
+#include <cstdint>
 #include <exception>
+#include <fstream>
+#include <set>
+#include <stdexcept>
 #include <string>
+#include <random>
 #include <iostream>
 
 using StabilizerCircuit = CliffordTableaus::StabilizerCircuit;
 using ImprovedStabilizerTableau = CliffordTableaus::ImprovedStabilizerTableau;
 
+/**
+ * Exposes the protected rowsum subroutine for testing.
+ */
+class RowsumProbe : public ImprovedStabilizerTableau {
+public:
+    using ImprovedStabilizerTableau::rowsum;
+};
+
+/**
+ * Exposes the storage of the tableau words for testing.
+ */
+class StorageProbe : public ImprovedStabilizerTableau {
+public:
+    [[nodiscard]] const uint64_t *data() const {
+        return tableau.data();
+    }
+};
+
+/**
+ * Applies the Pauli and SWAP gates by their decompositions into Hadamard, Phase and CNOT instead of the native rules.
+ */
+class DecomposedStabilizerTableau : public ImprovedStabilizerTableau {
+public:
+    void PauliX(CliffordTableaus::uint qubit) override {
+        StabilizerTableau::PauliX(qubit);
+    }
+
+    void PauliY(CliffordTableaus::uint qubit) override {
+        StabilizerTableau::PauliY(qubit);
+    }
+
+    void PauliZ(CliffordTableaus::uint qubit) override {
+        StabilizerTableau::PauliZ(qubit);
+    }
+
+    void SWAP(CliffordTableaus::uint qubit1, CliffordTableaus::uint qubit2) override {
+        StabilizerTableau::SWAP(qubit1, qubit2);
+    }
+};
+
+TEST(ImprovedStabilizerTableauTest, NativePaulisAndSwapMatchDecomposition) {
+    // The native rules must produce the same tableau as the decompositions into Hadamard, Phase and CNOT.
+    std::mt19937 generator(3);
+    for (unsigned int n: {2u, 7u, 64u, 70u}) {
+        ImprovedStabilizerTableau native;
+        DecomposedStabilizerTableau decomposed;
+        native.initializeTableau(n);
+        decomposed.initializeTableau(n);
+        ASSERT_NO_FATAL_FAILURE(apply_random_gates(native, decomposed, generator, n, 30 * n, false));
+
+        for (unsigned int i = 1; i <= 2 * n; ++i) {
+            for (unsigned int j = 1; j <= n; ++j) {
+                ASSERT_EQ(native.get_x(i, j), decomposed.get_x(i, j)) << "n=" << n;
+                ASSERT_EQ(native.get_z(i, j), decomposed.get_z(i, j)) << "n=" << n;
+            }
+            ASSERT_EQ(native.get_r(i), decomposed.get_r(i)) << "n=" << n;
+        }
+    }
+}
+
+TEST(ImprovedStabilizerTableauTest, SnapshotIncludesPendingPaulis) {
+    // Pauli gates are accumulated lazily, a snapshot must contain them without flushing the tableau.
+    ImprovedStabilizerTableau pending;
+    pending.initializeTableau(3);
+    pending.Hadamard(2);
+    pending.PauliX(1);
+    pending.PauliY(2);
+    pending.PauliZ(3);
+    pending.SWAP(1, 3);
+    CliffordTableaus::TableauSnapshot snapshot;
+    pending.saveSnapshot(snapshot);
+
+    ImprovedStabilizerTableau restored;
+    restored.restoreSnapshot(snapshot);
+    for (unsigned int i = 1; i <= 6; ++i) {
+        ASSERT_EQ(pending.get_r(i), restored.get_r(i)) << "i=" << i;
+    }
+    // X on qubit 1 flips the sign of the stabilizer Z1 in row 4, which the SWAP turns into -Z3.
+    EXPECT_EQ(restored.get_r(4), 1);
+    EXPECT_EQ(restored.get_r(6), 0);
+}
+
+TEST(ImprovedStabilizerTableauTest, InitializeTableauReusesStorage) {
+    // Reinitializing for the same or fewer qubits keeps the aligned words and resets them to |0...0>,
+    // including the pending Paulis and the scratch row.
+    StorageProbe probe;
+    probe.initializeTableau(70);
+    auto storage = probe.data();
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(storage) % 64, 0u);
+    unsigned int previous = 70;
+    for (unsigned int n: {70u, 20u, 1u}) {
+        for (unsigned int a = 1; a < previous; ++a) {
+            probe.Hadamard(a);
+            probe.CNOT(a, a + 1);
+            probe.PauliY(a);
+        }
+        probe.Measurement(1);
+        probe.initializeTableau(n);
+        ASSERT_EQ(probe.data(), storage) << "n=" << n;
+
+        ImprovedStabilizerTableau fresh;
+        fresh.initializeTableau(n);
+        for (unsigned int i = 1; i <= 2 * n; ++i) {
+            for (unsigned int j = 1; j <= n; ++j) {
+                ASSERT_EQ(probe.get_x(i, j), fresh.get_x(i, j)) << "n=" << n;
+                ASSERT_EQ(probe.get_z(i, j), fresh.get_z(i, j)) << "n=" << n;
+            }
+            ASSERT_EQ(probe.get_r(i), fresh.get_r(i)) << "n=" << n;
+        }
+        EXPECT_EQ(probe.Measurement(n), 0) << "n=" << n;
+        previous = n;
+    }
+}
+
+TEST(ImprovedStabilizerTableauTest, SingleQubitCliffordsMatchGates) {
+    // Exactly 24 of the 64 codes are Cliffords, and each must act like its decomposition into gates.
+    using namespace CliffordTableaus;
+    unsigned int valid_codes = 0;
+    for (uint32_t code = 0; code < 64; ++code) {
+        SingleQubitClifford clifford{};
+        try {
+            clifford = SingleQubitClifford::fromCode(code);
+        } catch (std::invalid_argument &) {
+            continue;
+        }
+        ++valid_codes;
+        ASSERT_EQ(clifford.code(), code);
+
+        auto composed = SingleQubitClifford::identity();
+        for (auto gate: clifford.decomposition()) {
+            composed = composed.then(SingleQubitClifford::fromInstruction({gate, 0, 0}));
+        }
+        ASSERT_EQ(composed, clifford) << "code=" << code;
+
+        // Start from a state with non-trivial phases, so that the signs of the images matter.
+        ImprovedStabilizerTableau direct;
+        ImprovedStabilizerTableau decomposed;
+        for (auto *tableau: {&direct, &decomposed}) {
+            tableau->initializeTableau(2);
+            tableau->Hadamard(1);
+            tableau->CNOT(1, 2);
+            tableau->Phase(2);
+            tableau->PauliX(1);
+        }
+        direct.Clifford(2, clifford);
+        decomposed.StabilizerTableau::Clifford(2, clifford);
+        for (unsigned int i = 1; i <= 4; ++i) {
+            for (unsigned int j = 1; j <= 2; ++j) {
+                ASSERT_EQ(direct.get_x(i, j), decomposed.get_x(i, j)) << "code=" << code;
+                ASSERT_EQ(direct.get_z(i, j), decomposed.get_z(i, j)) << "code=" << code;
+            }
+            ASSERT_EQ(direct.get_r(i), decomposed.get_r(i)) << "code=" << code;
+        }
+    }
+    ASSERT_EQ(valid_codes, 24u);
+}
+
+TEST(ImprovedStabilizerTableauTest, FixedStabilizerTableauMatchesImproved) {
+    // The fixed-size instantiations must evolve exactly like the runtime-sized tableau,
+    // including the phases as long as the random measurement outcomes agree.
+    std::mt19937 generator(17);
+    auto compare = [&generator](auto &fixed, unsigned int n) {
+        ImprovedStabilizerTableau improved;
+        improved.initializeTableau(n);
+        fixed.initializeTableau(n);
+        auto phases_agree = apply_random_gates(improved, fixed, generator, n, 20 * n, true);
+        for (unsigned int i = 1; i <= 2 * n; ++i) {
+            for (unsigned int j = 1; j <= n; ++j) {
+                ASSERT_EQ(improved.get_x(i, j), fixed.get_x(i, j)) << "n=" << n;
+                ASSERT_EQ(improved.get_z(i, j), fixed.get_z(i, j)) << "n=" << n;
+            }
+            if (phases_agree) {
+                ASSERT_EQ(improved.get_r(i), fixed.get_r(i)) << "n=" << n;
+            }
+        }
+    };
+    CliffordTableaus::FixedStabilizerTableau<64> fixed_64;
+    compare(fixed_64, 5);
+    compare(fixed_64, 64);
+    CliffordTableaus::FixedStabilizerTableau<128> fixed_128;
+    compare(fixed_128, 100);
+    EXPECT_THROW(fixed_64.initializeTableau(65), std::invalid_argument);
+}
+
+TEST(ImprovedStabilizerTableauTest, MeasureAllMatchesSequentialMeasurements) {
+    // MeasureAll must produce exactly the outcomes that measuring the qubits one by one can produce,
+    // and leave the tableau in the measured basis state. For up to 6 qubits, 1000 shots reach every
+    // possible outcome, for wider systems the outcomes of the determinate qubits are compared.
+    std::mt19937 generator(20);
+    CliffordTableaus::Rng rng(20);
+    for (unsigned int n: {1u, 4u, 6u, 70u, 130u}) {
+        ImprovedStabilizerTableau improved;
+        improved.setRng(&rng);
+        improved.initializeTableau(n);
+        std::uniform_int_distribution<unsigned int> qubit_dist(1, n);
+        for (unsigned int step = 0; step < 6 * n; ++step) {
+            auto a = qubit_dist(generator);
+            auto b = qubit_dist(generator);
+            improved.Hadamard(a);
+            improved.Phase(b);
+            improved.PauliY(b);
+            if (a != b) {
+                improved.CNOT(a, b);
+            }
+            // Measurements make some of the qubits determinate.
+            if (step % 7 == 0) {
+                improved.Measurement(b);
+            }
+        }
+        CliffordTableaus::TableauSnapshot snapshot;
+        improved.saveSnapshot(snapshot);
+        std::vector<int> determinate_outcomes(n, -1);
+        for (unsigned int a = 1; a <= n; ++a) {
+            if (!improved.hasRandomOutcome(a)) {
+                determinate_outcomes[a - 1] = improved.Measurement(a);
+            }
+        }
+
+        auto to_string = [](const std::vector<uint8_t> &outcomes) {
+            std::string measurement;
+            for (auto outcome: outcomes) {
+                measurement += static_cast<char>('0' + outcome);
+            }
+            return measurement;
+        };
+        std::set<std::string> sequential_outcomes;
+        std::set<std::string> batched_outcomes;
+        for (int shot = 0; shot < (n <= 6 ? 1000 : 20); ++shot) {
+            improved.restoreSnapshot(snapshot);
+            std::vector<uint8_t> outcomes;
+            for (unsigned int a = 1; a <= n; ++a) {
+                outcomes.push_back(improved.Measurement(a));
+            }
+            sequential_outcomes.insert(to_string(outcomes));
+
+            improved.restoreSnapshot(snapshot);
+            outcomes = improved.MeasureAll();
+            batched_outcomes.insert(to_string(outcomes));
+            for (unsigned int a = 1; a <= n; ++a) {
+                ASSERT_FALSE(improved.hasRandomOutcome(a)) << "n=" << n;
+                ASSERT_EQ(improved.Measurement(a), outcomes[a - 1]) << "n=" << n;
+                if (determinate_outcomes[a - 1] >= 0) {
+                    ASSERT_EQ(outcomes[a - 1], determinate_outcomes[a - 1]) << "n=" << n << " a=" << a;
+                }
+            }
+        }
+        if (n <= 6) {
+            ASSERT_EQ(sequential_outcomes, batched_outcomes) << "n=" << n;
+        }
+
+        // The fixed-size tableau shares the reduction and must agree on the determinate qubits as well.
+        CliffordTableaus::FixedStabilizerTableau<256> fixed;
+        fixed.initializeTableau(n);
+        improved.restoreSnapshot(snapshot);
+        for (unsigned int i = 1; i <= 2 * n; ++i) {
+            for (unsigned int j = 1; j <= n; ++j) {
+                fixed.set_x(i, j, improved.get_x(i, j));
+                fixed.set_z(i, j, improved.get_z(i, j));
+            }
+            fixed.set_r(i, improved.get_r(i));
+        }
+        auto outcomes = fixed.MeasureAll();
+        for (unsigned int a = 1; a <= n; ++a) {
+            if (determinate_outcomes[a - 1] >= 0) {
+                ASSERT_EQ(outcomes[a - 1], determinate_outcomes[a - 1]) << "n=" << n << " a=" << a;
+            }
+        }
+        if (n <= 6) {
+            ASSERT_EQ(sequential_outcomes.count(to_string(outcomes)), 1u) << "n=" << n;
+        }
+    }
+}
+
+TEST(ImprovedStabilizerTableauTest, PackedRowsumMatchesG) {
+    // Compare the packed rowsum against the reference computation via g() qubit by qubit.
+    // Generators within the stabilizer block always commute, so rowsum is valid for every such pair.
+    std::mt19937 generator(42);
+    for (unsigned int n: {1u, 3u, 63u, 64u, 65u, 130u}) {
+        RowsumProbe tableau;
+        tableau.initializeTableau(n);
+        std::uniform_int_distribution<unsigned int> qubit_dist(1, n);
+        std::uniform_int_distribution<unsigned int> stabilizer_dist(n + 1, 2 * n);
+        std::uniform_int_distribution<int> gate_dist(0, n >= 2 ? 2 : 1);
+
+        for (int round = 0; round < 200; ++round) {
+            for (unsigned int step = 0; step < 2 * n; ++step) {
+                auto a = qubit_dist(generator);
+                auto gate = gate_dist(generator);
+                if (gate == 0) {
+                    tableau.Hadamard(a);
+                } else if (gate == 1) {
+                    tableau.Phase(a);
+                } else {
+                    auto b = qubit_dist(generator);
+                    if (a != b) {
+                        tableau.CNOT(a, b);
+                    }
+                }
+            }
+
+            auto h = stabilizer_dist(generator);
+            auto i = stabilizer_dist(generator);
+            if (h == i) {
+                continue;
+            }
+            int sum_g = 2 * (tableau.get_r(h) + tableau.get_r(i));
+            std::vector<uint8_t> expected_x(n + 1);
+            std::vector<uint8_t> expected_z(n + 1);
+            for (unsigned int j = 1; j <= n; ++j) {
+                sum_g += CliffordTableaus::g(tableau.get_x(i, j), tableau.get_z(i, j),
+                                             tableau.get_x(h, j), tableau.get_z(h, j));
+                expected_x[j] = tableau.get_x(i, j) ^ tableau.get_x(h, j);
+                expected_z[j] = tableau.get_z(i, j) ^ tableau.get_z(h, j);
+            }
+            sum_g = ((sum_g % 4) + 4) % 4;
+            ASSERT_TRUE(sum_g == 0 || sum_g == 2);
+
+            tableau.rowsum(h, i);
+            ASSERT_EQ(tableau.get_r(h), sum_g / 2) << "n=" << n << " round=" << round;
+            for (unsigned int j = 1; j <= n; ++j) {
+                ASSERT_EQ(tableau.get_x(h, j), expected_x[j]) << "n=" << n << " round=" << round;
+                ASSERT_EQ(tableau.get_z(h, j), expected_z[j]) << "n=" << n << " round=" << round;
+            }
+        }
+    }
+}
+
+TEST(StabilizerCircuitTest, CompileCircuitOutput) {
+    CliffordTableaus::uint n = 0;
+    std::vector<CliffordTableaus::Instruction> instructions;
+    ASSERT_TRUE(StabilizerCircuit::compileCircuit("random_circuit_1.qasm", n, instructions));
+    ASSERT_EQ(n, 3);
+    ASSERT_EQ(instructions.size(), 13);
+    EXPECT_EQ(instructions[0].gate, CliffordTableaus::HADAMARD);
+    EXPECT_EQ(instructions[0].qubit1, 1);
+    EXPECT_EQ(instructions[1].gate, CliffordTableaus::CNOT);
+    EXPECT_EQ(instructions[1].qubit1, 1);
+    EXPECT_EQ(instructions[1].qubit2, 2);
+    EXPECT_EQ(instructions[12].gate, CliffordTableaus::MEASURE);
+    EXPECT_EQ(instructions[12].qubit1, 2);
+}
+
+TEST(StabilizerCircuitTest, CircuitOptimizerCancelsGates) {
+    using namespace CliffordTableaus;
+    // h; cx; cx; h cancels in cascade, s^4 and the swap pair cancel, x; z merges into y, id is dropped.
+    // The measurement in between keeps the last two CNOTs from cancelling.
+    std::vector<Instruction> instructions = {
+            {HADAMARD, 0, 0}, {CNOT, 0, 1}, {IDENTITY, 1, 0}, {CNOT, 0, 1}, {HADAMARD, 0, 0},
+            {PHASE, 2, 0}, {PHASE, 2, 0}, {SWAP, 1, 2}, {SWAP, 2, 1}, {PHASE, 2, 0}, {PHASE, 2, 0},
+            {PAULI_X, 1, 0}, {PAULI_Z, 1, 0}, {MEASURE, 1, 0}, {CNOT, 1, 0}, {MEASURE, 1, 0}, {CNOT, 1, 0}
+    };
+    OptimizationStats stats;
+    auto optimized = CircuitOptimizer::optimize(3, instructions, stats);
+    ASSERT_EQ(optimized.size(), 5u);
+    EXPECT_EQ(optimized[0].gate, PAULI_Y);
+    EXPECT_EQ(optimized[1].gate, MEASURE);
+    EXPECT_EQ(optimized[2].gate, CNOT);
+    EXPECT_EQ(optimized[3].gate, MEASURE);
+    EXPECT_EQ(optimized[4].gate, CNOT);
+    EXPECT_EQ(stats.gates_before, instructions.size());
+    EXPECT_EQ(stats.removed(), instructions.size() - 5);
+
+    // Qubit 0 keeps its measured outcome, qubit 1 is unmeasured even though its gates cancel.
+    CompiledCircuit circuit(2, {{MEASURE, 0, 0}, {MEASURE, 1, 0}, {HADAMARD, 1, 0}, {HADAMARD, 1, 0}});
+    ImprovedStabilizerTableau stabilizerTableau;
+    EXPECT_EQ(circuit.getProgram().size(), 2u);
+    EXPECT_EQ(circuit.run(stabilizerTableau), "0x");
+}
+
+TEST(StabilizerCircuitTest, QasmReaderParsesGateLines) {
+    using CliffordTableaus::QasmReader;
+    CliffordTableaus::Instruction instruction{};
+    ASSERT_TRUE(QasmReader::parseGateLine("swap q[12],q[3];", instruction));
+    EXPECT_EQ(instruction.gate, CliffordTableaus::SWAP);
+    EXPECT_EQ(instruction.qubit1, 12);
+    EXPECT_EQ(instruction.qubit2, 3);
+    ASSERT_TRUE(QasmReader::parseGateLine("measure q[0];", instruction));
+    EXPECT_EQ(instruction.gate, CliffordTableaus::MEASURE);
+    for (auto line: {"h q[1]", "h q[1]; ", "hq[1];", "h q[-1];", "h q[];", "cx q[1], q[2];", "cx q[1];",
+                     "x q[99999999999];", "t q[0];", ""}) {
+        EXPECT_FALSE(QasmReader::parseGateLine(line, instruction)) << line;
+    }
+    CliffordTableaus::uint n = 0;
+    ASSERT_TRUE(QasmReader::parseQregLine("qreg q[42];", n));
+    EXPECT_EQ(n, 42);
+    EXPECT_FALSE(QasmReader::parseQregLine("qreg q[42]", n));
+}
+
+TEST(StabilizerCircuitTest, BinaryCircuitRoundTrip) {
+    // Write the same random circuit in both formats and compare the loaded instructions.
+    StabilizerCircuit::createRandomStabilizerCircuit("binary_round_trip.qasm", 200, 2000, 7, 8, true, true, true);
+    StabilizerCircuit::createRandomStabilizerCircuit("binary_round_trip.ctbc", 200, 2000, 7, 8, true, true, true, true);
+    auto qasm_path = StabilizerCircuit::circuitFilePath("binary_round_trip.qasm");
+    auto binary_path = StabilizerCircuit::circuitFilePath("binary_round_trip.ctbc");
+    EXPECT_FALSE(CliffordTableaus::BinaryCircuit::isBinaryCircuit(qasm_path));
+    EXPECT_TRUE(CliffordTableaus::BinaryCircuit::isBinaryCircuit(binary_path));
+
+    auto text = CliffordTableaus::CompiledCircuit::load("binary_round_trip.qasm");
+    auto binary = CliffordTableaus::CompiledCircuit::load("binary_round_trip.ctbc");
+    std::filesystem::remove(qasm_path);
+    std::filesystem::remove(binary_path);
+    ASSERT_EQ(text.qubits(), binary.qubits());
+    ASSERT_EQ(text.optimizationStats().gates_before, 2200u);
+    ASSERT_EQ(binary.optimizationStats().gates_before, 2200u);
+    // The optimizer is deterministic, so equal parsed circuits yield equal programs.
+    ASSERT_EQ(text.getProgram().size(), binary.getProgram().size());
+    for (std::size_t k = 0; k < text.getProgram().size(); ++k) {
+        const auto &expected = text.getProgram()[k];
+        const auto &actual = binary.getProgram()[k];
+        ASSERT_EQ(expected.gate, actual.gate) << "Instruction " << k;
+        ASSERT_EQ(expected.qubit1, actual.qubit1) << "Instruction " << k;
+        if (expected.gate == CliffordTableaus::CNOT || expected.gate == CliffordTableaus::SWAP ||
+            expected.gate == CliffordTableaus::CLIFFORD) {
+            ASSERT_EQ(expected.qubit2, actual.qubit2) << "Instruction " << k;
+        }
+    }
+
+    // A header declaring more qubits than any tableau could hold is rejected before anything is allocated.
+    {
+        std::ofstream oversized(binary_path, std::ios::binary);
+        CliffordTableaus::BinaryCircuit::writeHeader(oversized, CliffordTableaus::BinaryCircuit::max_qubits + 1);
+    }
+    EXPECT_THROW(CliffordTableaus::CompiledCircuit::load("binary_round_trip.ctbc"), std::runtime_error);
+    std::filesystem::remove(binary_path);
+}
+
+TEST(StabilizerCircuitTest, CompiledCircuitRunsManyShots) {
+    auto circuit = CliffordTableaus::CompiledCircuit::load("random_circuit_2.qasm");
+    ASSERT_EQ(circuit.qubits(), 5);
+    ImprovedStabilizerTableau stabilizerTableau = ImprovedStabilizerTableau();
+    CliffordTableaus::Rng rng(5);
+    std::string expected = "00110|01100|10011|11001";
+    for (int shot = 1; shot <= 500; shot++) {
+        auto actual = circuit.run(stabilizerTableau, rng);
+        ASSERT_NE(expected.find(actual), std::string::npos) << "Shot " << shot << " measured " << actual;
+    }
+    EXPECT_THROW(CliffordTableaus::CompiledCircuit::load("does_not_exist.qasm"), std::runtime_error);
+}
+
+TEST(StabilizerCircuitTest, InstantiatedRunMatchesVirtualRun) {
+    // With the same random bits, executing a shot through the instantiation for the concrete tableau type
+    // must measure exactly what the virtual interface measures.
+    auto circuit = CliffordTableaus::CompiledCircuit::load("random_circuit_6.qasm");
+    ImprovedStabilizerTableau stabilizerTableau = ImprovedStabilizerTableau();
+    CliffordTableaus::FixedStabilizerTableau<128> fixedTableau;
+    CliffordTableaus::Rng virtual_rng(3);
+    CliffordTableaus::Rng instantiated_rng(3);
+    CliffordTableaus::Rng fixed_rng(3);
+    for (int shot = 1; shot <= 20; shot++) {
+        auto expected = circuit.run(static_cast<CliffordTableaus::StabilizerTableau &>(stabilizerTableau), virtual_rng);
+        ASSERT_EQ(circuit.run(stabilizerTableau, instantiated_rng), expected) << "Shot " << shot;
+        ASSERT_EQ(circuit.run(fixedTableau, fixed_rng), expected) << "Shot " << shot;
+    }
+}
+
+TEST(StabilizerCircuitTest, RunFromPrefixRestoresSnapshot) {
+    auto circuit = CliffordTableaus::CompiledCircuit::load("random_circuit_2.qasm");
+    ImprovedStabilizerTableau prefixTableau = ImprovedStabilizerTableau();
+    auto prefix = circuit.simulatePrefix(prefixTableau);
+    ASSERT_GT(prefix.length, 0);
+    ASSERT_LT(prefix.length, circuit.getProgram().size());
+
+    // The restored tableau must hold exactly the state after the prefix.
+    ImprovedStabilizerTableau stabilizerTableau = ImprovedStabilizerTableau();
+    stabilizerTableau.initializeTableau(1);
+    stabilizerTableau.restoreSnapshot(prefix.snapshot);
+    for (std::size_t i = 1; i <= 2 * circuit.qubits(); ++i) {
+        for (std::size_t j = 1; j <= circuit.qubits(); ++j) {
+            ASSERT_EQ(prefixTableau.get_x(i, j), stabilizerTableau.get_x(i, j));
+            ASSERT_EQ(prefixTableau.get_z(i, j), stabilizerTableau.get_z(i, j));
+        }
+        ASSERT_EQ(prefixTableau.get_r(i), stabilizerTableau.get_r(i));
+    }
+
+    CliffordTableaus::Rng rng(11);
+    std::string expected = "00110|01100|10011|11001";
+    for (int shot = 1; shot <= 500; shot++) {
+        auto actual = circuit.runFromPrefix(prefix, stabilizerTableau, rng);
+        ASSERT_NE(expected.find(actual), std::string::npos) << "Shot " << shot << " measured " << actual;
+    }
+}
+
+TEST(StabilizerCircuitTest, ShotRunnerMergesThreadHistograms) {
+    auto circuit = CliffordTableaus::CompiledCircuit::load("random_circuit_2.qasm");
+    auto histogram = CliffordTableaus::ShotRunner::runShots(
+            circuit,
+            [] { return std::make_unique<ImprovedStabilizerTableau>(); },
+            1000,
+            4
+    );
+    std::string expected = "00110|01100|10011|11001";
+    unsigned int total = 0;
+    for (const auto &[measurement, count]: histogram) {
+        ASSERT_NE(expected.find(measurement), std::string::npos) << "Measured " << measurement;
+        total += count;
+    }
+    ASSERT_EQ(total, 1000);
+}
+
+TEST(StabilizerCircuitTest, ShotRunnerIsReproducibleAcrossThreadCounts) {
+    // Every shot and every frame batch draws from the stream of its index, so a seed fixes the histogram.
+    auto circuit = CliffordTableaus::CompiledCircuit::load("random_circuit_2.qasm");
+    auto factory = [] { return std::make_unique<ImprovedStabilizerTableau>(); };
+    for (auto run: {CliffordTableaus::ShotRunner::runShots, CliffordTableaus::ShotRunner::sampleFrames}) {
+        auto histogram = run(circuit, factory, 3000, 1, nullptr, 42);
+        ASSERT_EQ(run(circuit, factory, 3000, 4, nullptr, 42), histogram);
+        ASSERT_EQ(run(circuit, factory, 3000, 3, nullptr, 42), histogram);
+        ASSERT_NE(run(circuit, factory, 3000, 1, nullptr, 43), histogram);
+    }
+}
+
+TEST(StabilizerCircuitTest, ExactDistributionMatchesShots) {
+    using namespace CliffordTableaus;
+    ImprovedStabilizerTableau tableau;
+    // A GHZ state yields 000 and 111, the qubit which is not measured is reported as 'x' in both.
+    CompiledCircuit ghz(4, {{HADAMARD, 0, 0}, {CNOT, 0, 1}, {CNOT, 1, 2}, {CNOT, 2, 3},
+                            {MEASURE, 0, 0}, {MEASURE, 2, 0}, {MEASURE, 1, 0}});
+    auto distribution = ghz.exactDistribution(tableau);
+    auto outcomes = distribution.outcomes();
+    std::sort(outcomes.begin(), outcomes.end());
+    ASSERT_EQ(outcomes, (std::vector<std::string>{"000x", "111x"}));
+    ASSERT_EQ(distribution.probability(), 0.5);
+    ASSERT_FALSE(distribution.contains("010x"));
+
+    // Gates after a measurement cannot be deferred, the frames of a reference shot yield the distribution instead.
+    CompiledCircuit reused(2, {{HADAMARD, 0, 0}, {MEASURE, 0, 0}, {HADAMARD, 0, 0}, {CNOT, 0, 1},
+                               {MEASURE, 0, 0}, {MEASURE, 1, 0}});
+    outcomes = reused.exactDistribution(tableau).outcomes();
+    std::sort(outcomes.begin(), outcomes.end());
+    ASSERT_EQ(outcomes, (std::vector<std::string>{"00", "11"}));
+
+    // Every tableau type and the frames yield the same reduced subspace, which contains every sampled outcome.
+    auto circuit = CompiledCircuit::load("random_circuit_2.qasm");
+    auto exact = circuit.exactDistribution(tableau);
+    auto frames = FrameSimulator(circuit, circuit.run(tableau)).outcomeSpace();
+    PackedStabilizerTableau packed;
+    SparseStabilizerTableau sparse;
+    FixedStabilizerTableau<64> fixed;
+    for (StabilizerTableau *other: std::initializer_list<StabilizerTableau *>{&packed, &sparse, &fixed}) {
+        auto other_exact = circuit.exactDistribution(*other);
+        ASSERT_EQ(other_exact.offsetString(), exact.offsetString());
+        ASSERT_EQ(other_exact.basisStrings(), exact.basisStrings());
+    }
+    ASSERT_EQ(frames.offsetString(), exact.offsetString());
+    ASSERT_EQ(frames.basisStrings(), exact.basisStrings());
+    for (const auto *name: {"random_circuit_2.qasm", "random_circuit_9.qasm"}) {
+        auto sampled = CompiledCircuit::load(name);
+        auto sampled_exact = sampled.exactDistribution(tableau);
+        auto histogram = ShotRunner::runShots(
+                sampled, [] { return std::make_unique<ImprovedStabilizerTableau>(); }, 500, 1, nullptr, 7
+        );
+        for (const auto &[measurement, count]: histogram) {
+            ASSERT_TRUE(sampled_exact.contains(measurement)) << name << " measured " << measurement;
+        }
+    }
+}
+
+TEST(StabilizerCircuitTest, StatsCountMeasurementsByOutcome) {
+    // Every shot of random_circuit_2 ends with measurements, the counts only grow in instrumented builds.
+    using CliffordTableaus::Stats;
+    Stats::reset();
+    auto circuit = CliffordTableaus::CompiledCircuit::load("random_circuit_2.qasm");
+    ImprovedStabilizerTableau stabilizerTableau;
+    CliffordTableaus::Rng rng(5);
+    for (int shot = 0; shot < 10; ++shot) {
+        circuit.run(stabilizerTableau, rng);
+    }
+    auto entries = Stats::collect();
+    auto measurements = entries[CliffordTableaus::STATS_RANDOM_MEASUREMENT].count +
+                        entries[CliffordTableaus::STATS_DETERMINATE_MEASUREMENT].count +
+                        entries[CliffordTableaus::STATS_MEASURE_ALL].count;
+    auto json = Stats::toJson();
+    if (Stats::enabled) {
+        ASSERT_EQ(entries[CliffordTableaus::STATS_PARSE].count, 1u);
+        ASSERT_GT(measurements, 0);
+        ASSERT_NE(json.find("\"enabled\": true"), std::string::npos) << json;
+    } else {
+        ASSERT_EQ(measurements, 0u);
+        ASSERT_NE(json.find("\"enabled\": false"), std::string::npos) << json;
+    }
+    ASSERT_NE(json.find("\"random\": {\"count\": "), std::string::npos) << json;
+}
+
 TEST(StabilizerCircuitTest, Bernstein16NoError) {
     ImprovedStabilizerTableau stabilizerTableau = ImprovedStabilizerTableau();
     std::string filename = "bernstein_16.qasm";
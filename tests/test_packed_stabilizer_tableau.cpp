@@ -0,0 +1,276 @@
+#include "stabilizer_circuit.h"
+#include "compiled_circuit.h"
+#include "shot_runner.h"
+#include "improved_simulation_of_stabilizer_circuits/improved_stabilizer_tableau.h"
+#include "stim_a_fast_stabilizer_circuit_simulator/packed_stabilizer_tableau.h"
+#include "stim_a_fast_stabilizer_circuit_simulator/simd_kernels.h"
+#include "gtest/gtest.h"
+#include "random_gates.h"
+
+#include <exception>
+#include <string>
+#include <random>
+#include <vector>
+#include <iostream>
+
+using StabilizerCircuit = CliffordTableaus::StabilizerCircuit;
+using ImprovedStabilizerTableau = CliffordTableaus::ImprovedStabilizerTableau;
+using PackedStabilizerTableau = CliffordTableaus::PackedStabilizerTableau;
+
+TEST(PackedStabilizerTableauTest, MatchesImprovedStabilizerTableau) {
+    // Apply the same random gate sequences to both tableaus and compare every bit.
+    // Random measurement outcomes are drawn independently by both tableaus,
+    // so the phase bits are only compared for as long as all outcomes agreed.
+    // Measurements come in blocks of five on two qubits, so the packed tableau switches to its rows in the block
+    // and is compared in the row-major layout until the next gate transposes it back.
+    std::mt19937 generator(1234);
+    for (unsigned int n: {1u, 2u, 5u, 31u, 32u, 33u, 70u}) {
+        ImprovedStabilizerTableau improved;
+        PackedStabilizerTableau packed;
+        improved.initializeTableau(n);
+        packed.initializeTableau(n);
+        auto check = [&](unsigned int step, bool phases_agree) {
+            for (unsigned int i = 1; i <= 2 * n; ++i) {
+                for (unsigned int j = 1; j <= n; ++j) {
+                    ASSERT_EQ(improved.get_x(i, j), packed.get_x(i, j)) << "n=" << n << " step=" << step;
+                    ASSERT_EQ(improved.get_z(i, j), packed.get_z(i, j)) << "n=" << n << " step=" << step;
+                }
+                if (phases_agree) {
+                    ASSERT_EQ(improved.get_r(i), packed.get_r(i)) << "n=" << n << " step=" << step;
+                }
+            }
+        };
+        ASSERT_NO_FATAL_FAILURE(apply_random_gates(improved, packed, generator, n, 40 * n, true, check));
+
+        // A snapshot taken in the row-major layout holds the columns.
+        for (int repetition = 0; repetition < 4; ++repetition) {
+            packed.Measurement(1);
+        }
+        CliffordTableaus::TableauSnapshot snapshot;
+        packed.saveSnapshot(snapshot);
+        PackedStabilizerTableau restored;
+        restored.restoreSnapshot(snapshot);
+        for (unsigned int i = 1; i <= 2 * n; ++i) {
+            for (unsigned int j = 1; j <= n; ++j) {
+                ASSERT_EQ(packed.get_x(i, j), restored.get_x(i, j)) << "n=" << n;
+                ASSERT_EQ(packed.get_z(i, j), restored.get_z(i, j)) << "n=" << n;
+            }
+            ASSERT_EQ(packed.get_r(i), restored.get_r(i)) << "n=" << n;
+        }
+    }
+}
+
+TEST(PackedStabilizerTableauTest, MeasuringAllQubitsMatchesImproved) {
+    // Packed computes determinate outcomes column by column instead of with rowsums into the scratch space,
+    // unless the measurements follow each other and run on the rows. With the same random bits,
+    // measuring every qubit of a scrambled state twice, where the second round is entirely determinate,
+    // must give the outcomes of the improved tableau. A Pauli-Z before every measurement keeps Packed on its columns.
+    std::mt19937 generator(19);
+    for (auto [n, interleaved]: {std::pair{1u, false}, std::pair{5u, true}, std::pair{63u, false},
+                                 std::pair{64u, true}, std::pair{65u, false}, std::pair{65u, true},
+                                 std::pair{130u, false}, std::pair{130u, true}}) {
+        ImprovedStabilizerTableau improved;
+        PackedStabilizerTableau packed;
+        CliffordTableaus::Rng improved_rng(n);
+        CliffordTableaus::Rng packed_rng(n);
+        improved.setRng(&improved_rng);
+        packed.setRng(&packed_rng);
+        improved.initializeTableau(n);
+        packed.initializeTableau(n);
+        std::uniform_int_distribution<unsigned int> qubit_dist(1, n);
+        for (unsigned int step = 0; step < 10 * n; ++step) {
+            auto a = qubit_dist(generator);
+            auto b = qubit_dist(generator);
+            if (step % 3 == 0 && a != b) {
+                improved.CNOT(a, b);
+                packed.CNOT(a, b);
+            } else if (step % 3 == 1) {
+                improved.Hadamard(a);
+                packed.Hadamard(a);
+            } else {
+                improved.Phase(a);
+                packed.Phase(a);
+                improved.PauliX(b);
+                packed.PauliX(b);
+            }
+        }
+        for (int round = 0; round < 2; ++round) {
+            for (unsigned int a = 1; a <= n; ++a) {
+                if (interleaved) {
+                    improved.PauliZ(a);
+                    packed.PauliZ(a);
+                }
+                ASSERT_EQ(improved.hasRandomOutcome(a), packed.hasRandomOutcome(a)) << "n=" << n << " a=" << a;
+                ASSERT_EQ(improved.Measurement(a), packed.Measurement(a)) << "n=" << n << " a=" << a;
+            }
+        }
+    }
+}
+
+TEST(PackedStabilizerTableauTest, FusedLayersMatchSequentialGates) {
+    // Running a compiled circuit fuses single-qubit runs and applies layers at once,
+    // which must produce the same tableau as applying the raw instructions one by one.
+    using namespace CliffordTableaus;
+    std::mt19937 generator(11);
+    for (unsigned int n: {1u, 3u, 64u, 70u}) {
+        std::uniform_int_distribution<uint32_t> qubit_dist(0, n - 1);
+        std::uniform_int_distribution<int> gate_dist(0, n >= 2 ? 8 : 6);
+        std::vector<Instruction> instructions;
+        for (unsigned int step = 0; step < 30 * n; ++step) {
+            auto a = qubit_dist(generator);
+            auto b = qubit_dist(generator);
+            auto gate = static_cast<Gate>(gate_dist(generator));
+            if (gate == MEASURE || ((gate == CNOT || gate == SWAP) && a == b)) {
+                continue;
+            }
+            instructions.push_back({gate, a, b});
+        }
+        CompiledCircuit circuit(n, instructions);
+        ASSERT_LE(circuit.getProgram().size(), instructions.size());
+
+        ImprovedStabilizerTableau sequential;
+        sequential.initializeTableau(n);
+        for (const auto &instruction: instructions) {
+            sequential.applyGate(instruction);
+        }
+        ImprovedStabilizerTableau improved;
+        PackedStabilizerTableau packed;
+        circuit.run(improved);
+        circuit.run(packed);
+
+        for (unsigned int i = 1; i <= 2 * n; ++i) {
+            for (unsigned int j = 1; j <= n; ++j) {
+                ASSERT_EQ(sequential.get_x(i, j), improved.get_x(i, j)) << "n=" << n;
+                ASSERT_EQ(sequential.get_z(i, j), improved.get_z(i, j)) << "n=" << n;
+                ASSERT_EQ(sequential.get_x(i, j), packed.get_x(i, j)) << "n=" << n;
+                ASSERT_EQ(sequential.get_z(i, j), packed.get_z(i, j)) << "n=" << n;
+            }
+            ASSERT_EQ(sequential.get_r(i), improved.get_r(i)) << "n=" << n;
+            ASSERT_EQ(sequential.get_r(i), packed.get_r(i)) << "n=" << n;
+        }
+    }
+}
+
+TEST(PackedStabilizerTableauTest, Bernstein16NoError) {
+    PackedStabilizerTableau stabilizerTableau = PackedStabilizerTableau();
+    std::string expected = "1111111111111111";
+    std::string actual;
+    try {
+        actual = StabilizerCircuit::executeCircuit("bernstein_16.qasm", stabilizerTableau);
+        if (actual != expected) {
+            std::cout << "Expected: " << expected << std::endl << "  Actual: " << actual << std::endl;
+            FAIL();
+        }
+    } catch (std::exception &e) {
+        std::cout << "Bernstein 16 threw exception: " << e.what() << std::endl;
+        FAIL();
+    }
+}
+
+TEST(PackedStabilizerTableauTest, TestCircuit3Output) {
+    auto nr_shots = 500;
+    PackedStabilizerTableau stabilizerTableau = PackedStabilizerTableau();
+    std::string expected = "0000000000|0000011111|1111100000|1111111111";
+    std::string actual;
+    try {
+        for (int shot = 1; shot <= nr_shots; shot++) {
+            actual = StabilizerCircuit::executeCircuit("test_circuit_3.qasm", stabilizerTableau);
+            if (expected.find(actual) == std::string::npos) {
+                std::cout << "Test 3 failed on shot: " << shot << std::endl;
+                std::cout << "Expected: " << expected << std::endl << "  Actual: " << actual << std::endl;
+                FAIL();
+            }
+        }
+    } catch (std::exception &e) {
+        std::cout << "Test 3 threw exception: " << e.what() << std::endl;
+        FAIL();
+    }
+}
+
+TEST(PackedStabilizerTableauTest, TestCircuit11Output) {
+    auto nr_shots = 500;
+    PackedStabilizerTableau stabilizerTableau = PackedStabilizerTableau();
+    std::string expected = "0000|1000|0100|1100|0010|1010|0110|1110";
+    std::string actual;
+    try {
+        for (int shot = 1; shot <= nr_shots; shot++) {
+            actual = StabilizerCircuit::executeCircuit("test_circuit_11.qasm", stabilizerTableau);
+            if (expected.find(actual) == std::string::npos) {
+                std::cout << "Test 11 failed on shot: " << shot << std::endl;
+                std::cout << "Expected: " << expected << std::endl << "  Actual: " << actual << std::endl;
+                FAIL();
+            }
+        }
+    } catch (std::exception &e) {
+        std::cout << "Test 11 threw exception: " << e.what() << std::endl;
+        FAIL();
+    }
+}
+
+TEST(FrameSimulatorTest, SamplesUniformOutcomes) {
+    // Both circuits measure every outcome of the expected set with equal probability.
+    for (auto [filename, expected]: {
+            std::pair<std::string, std::string>{"test_circuit_3.qasm", "0000000000|0000011111|1111100000|1111111111"},
+            std::pair<std::string, std::string>{"test_circuit_11.qasm", "0000|1000|0100|1100|0010|1010|0110|1110"}
+    }) {
+        auto circuit = CliffordTableaus::CompiledCircuit::load(filename);
+        auto num_shots = 5000u;
+        auto histogram = CliffordTableaus::ShotRunner::sampleFrames(
+                circuit,
+                [] { return std::make_unique<PackedStabilizerTableau>(); },
+                num_shots,
+                2
+        );
+        auto num_outcomes = (expected.size() + 1) / (circuit.qubits() + 1);
+        ASSERT_EQ(histogram.size(), num_outcomes) << filename;
+        for (const auto &[measurement, count]: histogram) {
+            ASSERT_NE(expected.find(measurement), std::string::npos) << filename << " measured " << measurement;
+            EXPECT_GT(count, 3 * num_shots / num_outcomes / 4) << filename << " measured " << measurement;
+        }
+    }
+}
+
+TEST(SimdKernelsTest, VectorizedKernelsMatchScalar) {
+    using namespace CliffordTableaus;
+    std::mt19937_64 generator(7);
+    const auto &scalar = simd_kernels(SIMD_SCALAR);
+    for (auto level: {SIMD_AVX2, SIMD_AVX512, SIMD_AVX512_VPOPCNTDQ}) {
+        if (level > detect_simd_level()) {
+            std::cout << "Skipping unsupported SIMD level " << simd_level_name(level) << std::endl;
+            continue;
+        }
+        const auto &vectorized = simd_kernels(level);
+        for (std::size_t words = 1; words <= 37; ++words) {
+            // Six random operands per kernel, one copy for the scalar and one for the vectorized kernel.
+            std::vector<std::vector<uint64_t>> expected(6, std::vector<uint64_t>(words));
+            for (auto &operand: expected) {
+                for (auto &word: operand) {
+                    word = generator();
+                }
+            }
+            auto actual = expected;
+
+            scalar.xor_words(expected[0].data(), expected[1].data(), words);
+            vectorized.xor_words(actual[0].data(), actual[1].data(), words);
+            ASSERT_EQ(scalar.g_packed(expected[0].data(), expected[1].data(), expected[2].data(),
+                                      expected[3].data(), words),
+                      vectorized.g_packed(actual[0].data(), actual[1].data(), actual[2].data(),
+                                          actual[3].data(), words));
+            scalar.hadamard_columns(expected[0].data(), expected[1].data(), expected[2].data(), words);
+            vectorized.hadamard_columns(actual[0].data(), actual[1].data(), actual[2].data(), words);
+            scalar.phase_columns(expected[1].data(), expected[3].data(), expected[4].data(), words);
+            vectorized.phase_columns(actual[1].data(), actual[3].data(), actual[4].data(), words);
+            scalar.cnot_columns(expected[0].data(), expected[1].data(), expected[2].data(), expected[3].data(),
+                                expected[4].data(), words);
+            vectorized.cnot_columns(actual[0].data(), actual[1].data(), actual[2].data(), actual[3].data(),
+                                    actual[4].data(), words);
+            for (uint8_t source = 1; source < 4; ++source) {
+                scalar.rowsum_column(expected[0].data(), expected[1].data(), expected[2].data(),
+                                     expected[3].data(), expected[5].data(), source >> 1, source & 1, words);
+                vectorized.rowsum_column(actual[0].data(), actual[1].data(), actual[2].data(),
+                                         actual[3].data(), actual[5].data(), source >> 1, source & 1, words);
+            }
+            ASSERT_EQ(expected, actual) << "level=" << simd_level_name(level) << " words=" << words;
+        }
+    }
+}
@@ -0,0 +1,95 @@
+#include "stabilizer_circuit.h"
+#include "improved_simulation_of_stabilizer_circuits/improved_stabilizer_tableau.h"
+#include "sparse_stabilizer_tableau/sparse_stabilizer_tableau.h"
+#include "gtest/gtest.h"
+#include "random_gates.h"
+
+#include <exception>
+#include <string>
+#include <random>
+#include <iostream>
+
+using StabilizerCircuit = CliffordTableaus::StabilizerCircuit;
+using ImprovedStabilizerTableau = CliffordTableaus::ImprovedStabilizerTableau;
+using SparseStabilizerTableau = CliffordTableaus::SparseStabilizerTableau;
+
+TEST(SparseStabilizerTableauTest, MatchesImprovedStabilizerTableau) {
+    // Same differential test as for the packed tableau. The sizes cover generators in both forms:
+    // with 200 qubits random circuits quickly push generators beyond the dense threshold.
+    std::mt19937 generator(4321);
+    for (unsigned int n: {1u, 2u, 5u, 33u, 200u}) {
+        ImprovedStabilizerTableau improved;
+        SparseStabilizerTableau sparse;
+        improved.initializeTableau(n);
+        sparse.initializeTableau(n);
+        auto check = [&](unsigned int step, bool phases_agree) {
+            if (n > 33 && step % 50 != 49) {
+                return;
+            }
+            for (unsigned int i = 1; i <= 2 * n; ++i) {
+                unsigned int support = 0;
+                for (unsigned int j = 1; j <= n; ++j) {
+                    ASSERT_EQ(improved.get_x(i, j), sparse.get_x(i, j)) << "n=" << n << " step=" << step;
+                    ASSERT_EQ(improved.get_z(i, j), sparse.get_z(i, j)) << "n=" << n << " step=" << step;
+                    support += improved.get_x(i, j) | improved.get_z(i, j);
+                }
+                ASSERT_EQ(sparse.support(i), support) << "n=" << n << " step=" << step;
+                if (phases_agree) {
+                    ASSERT_EQ(improved.get_r(i), sparse.get_r(i)) << "n=" << n << " step=" << step;
+                }
+            }
+        };
+        ASSERT_NO_FATAL_FAILURE(apply_random_gates(improved, sparse, generator, n, 20 * n, true, check));
+
+        // Restoring a snapshot reproduces the tableau.
+        CliffordTableaus::TableauSnapshot snapshot;
+        sparse.saveSnapshot(snapshot);
+        SparseStabilizerTableau restored;
+        restored.restoreSnapshot(snapshot);
+        for (unsigned int i = 1; i <= 2 * n; ++i) {
+            for (unsigned int j = 1; j <= n; ++j) {
+                ASSERT_EQ(sparse.get_x(i, j), restored.get_x(i, j)) << "n=" << n;
+                ASSERT_EQ(sparse.get_z(i, j), restored.get_z(i, j)) << "n=" << n;
+            }
+            ASSERT_EQ(sparse.get_r(i), restored.get_r(i)) << "n=" << n;
+        }
+    }
+}
+
+TEST(SparseStabilizerTableauTest, LocalCircuitStaysSparse) {
+    // Bell pairs on neighbouring qubits of a wide register never spread beyond two qubits.
+    unsigned int n = 4096;
+    SparseStabilizerTableau sparse;
+    sparse.initializeTableau(n);
+    for (unsigned int a = 1; a < n; a += 2) {
+        sparse.Hadamard(a);
+        sparse.CNOT(a, a + 1);
+    }
+    for (unsigned int i = 1; i <= 2 * n; ++i) {
+        ASSERT_LE(sparse.support(i), 2u) << "i=" << i;
+    }
+    for (unsigned int a = 1; a < n; a += 2) {
+        auto outcome = sparse.Measurement(a);
+        ASSERT_EQ(sparse.Measurement(a + 1), outcome) << "a=" << a;
+    }
+}
+
+TEST(SparseStabilizerTableauTest, TestCircuit3Output) {
+    auto nr_shots = 500;
+    SparseStabilizerTableau stabilizerTableau = SparseStabilizerTableau();
+    std::string expected = "0000000000|0000011111|1111100000|1111111111";
+    std::string actual;
+    try {
+        for (int shot = 1; shot <= nr_shots; shot++) {
+            actual = StabilizerCircuit::executeCircuit("test_circuit_3.qasm", stabilizerTableau);
+            if (expected.find(actual) == std::string::npos) {
+                std::cout << "Test 3 failed on shot: " << shot << std::endl;
+                std::cout << "Expected: " << expected << std::endl << "  Actual: " << actual << std::endl;
+                FAIL();
+            }
+        }
+    } catch (std::exception &e) {
+        std::cout << "Test 3 threw exception: " << e.what() << std::endl;
+        FAIL();
+    }
+}
@@ -0,0 +1,53 @@
+#include "binary_circuit.h"
+#include "qasm_reader.h"
+
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+using namespace CliffordTableaus;
+
+/**
+ * Convert a circuit from QASM3 into the binary format of BinaryCircuit.
+ * The circuit is streamed chunk by chunk, so circuits of any size can be converted.
+ */
+int main(int argc, char *argv[]) {
+    if (argc != 3) {
+        std::cerr << "Usage: " << argv[0] << " <input.qasm> <output_filename>" << std::endl;
+        return 1;
+    }
+
+    try {
+        QasmReader reader(argv[1]);
+        CliffordTableaus::uint n_qubits;
+        if (!reader.readHeader(n_qubits)) {
+            return 1;
+        }
+
+        std::ofstream output(argv[2], std::ios::out | std::ios::binary);
+        if (!output) {
+            std::cerr << "Error: Unable to write to file: " << argv[2] << std::endl;
+            return 1;
+        }
+        BinaryCircuit::writeHeader(output, n_qubits);
+
+        std::vector<Instruction> chunk;
+        std::size_t num_instructions = 0;
+        while (reader.readChunk(chunk) > 0) {
+            for (const auto &instruction: chunk) {
+                BinaryCircuit::writeInstruction(output, instruction);
+            }
+            num_instructions += chunk.size();
+        }
+        output.close();
+        if (!output) {
+            std::cerr << "Error: Unable to write to file: " << argv[2] << std::endl;
+            return 1;
+        }
+        std::cout << "Converted " << num_instructions << " instructions on " << n_qubits << " qubits." << std::endl;
+    } catch (const std::exception &e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}